@@ -0,0 +1,141 @@
+#pragma once
+#include <SDL.h>
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchmarkResult {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    std::vector<std::pair<std::string, double>> counters;
+    long long itemsPerSample;
+    int samples;
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double maxNs;
+};
+
+// Times a body a fixed number of times, running an untimed setup before each
+// sample so destructive bodies (add/remove, spawn/expire) start from the same
+// state every time. Per-sample times rather than a single total are kept so
+// the median is available when a sample is disturbed by the OS.
+class BenchmarkRunner {
+private:
+    std::vector<BenchmarkResult> results;
+    std::string filter;
+    double sampleScale;
+    bool lastMeasured = false;
+
+public:
+    BenchmarkRunner(const std::string& filter, double sampleScale)
+        : filter(filter), sampleScale(sampleScale) {}
+
+    bool enabled(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Whether any benchmark named "<prefix>..." can pass the filter, so a
+    // group can skip its setup. Names have a single '/', right after the
+    // group, so a filter containing '/' must line it up with the group's.
+    bool enabledGroup(const std::string& prefix) const {
+        size_t slash = filter.find('/');
+        if (slash == std::string::npos) return true;
+        std::string head = filter.substr(0, slash + 1);
+        return prefix.size() >= head.size() &&
+               prefix.compare(prefix.size() - head.size(), head.size(), head) == 0;
+    }
+
+    void measure(const std::string& name, std::vector<std::pair<std::string, std::string>> params,
+                 long long itemsPerSample, int samples,
+                 const std::function<void()>& setup, const std::function<void()>& body) {
+        lastMeasured = enabled(name);
+        if (!lastMeasured) return;
+
+        samples = std::max(1, (int)(samples * sampleScale));
+        const double nsPerCount = 1e9 / (double)SDL_GetPerformanceFrequency();
+
+        std::vector<double> times;
+        times.reserve(samples);
+        for (int i = 0; i < samples; ++i) {
+            if (setup) setup();
+            Uint64 start = SDL_GetPerformanceCounter();
+            body();
+            Uint64 end = SDL_GetPerformanceCounter();
+            times.push_back((double)(end - start) * nsPerCount);
+            frameArena().reset();
+        }
+
+        std::vector<double> sortedTimes = times;
+        std::sort(sortedTimes.begin(), sortedTimes.end());
+        double total = 0.0;
+        for (double time : times) total += time;
+
+        BenchmarkResult result;
+        result.name = name;
+        result.params = std::move(params);
+        result.itemsPerSample = itemsPerSample;
+        result.samples = samples;
+        result.minNs = sortedTimes.front();
+        result.medianNs = sortedTimes[sortedTimes.size() / 2];
+        result.meanNs = total / samples;
+        result.maxNs = sortedTimes.back();
+        results.push_back(result);
+
+        std::string label = name;
+        for (const auto& param : result.params) {
+            label += " " + param.first + "=" + param.second;
+        }
+        printf("%-60s %12.1f ns/item  %12.3f ms/sample  (%d samples)\n", label.c_str(),
+               result.medianNs / std::max(1LL, itemsPerSample), result.medianNs / 1e6, samples);
+        fflush(stdout);
+    }
+
+    // Attaches an extra measurement (e.g. live particle count) to the result
+    // just recorded; dropped if the filter skipped that measure.
+    void counter(const std::string& name, double value) {
+        if (lastMeasured) {
+            results.back().counters.emplace_back(name, value);
+        }
+    }
+
+    bool writeJson(const char* path, const std::vector<std::pair<std::string, std::string>>& context) const {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr) return false;
+
+        fprintf(file, "{\n  \"context\": {");
+        for (size_t i = 0; i < context.size(); ++i) {
+            fprintf(file, "%s\"%s\": \"%s\"", i == 0 ? "" : ", ", context[i].first.c_str(), context[i].second.c_str());
+        }
+        fprintf(file, "},\n  \"benchmarks\": [\n");
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchmarkResult& result = results[i];
+            double perItem = result.medianNs / std::max(1LL, result.itemsPerSample);
+
+            fprintf(file, "    {\"name\": \"%s\", \"params\": {", result.name.c_str());
+            for (size_t j = 0; j < result.params.size(); ++j) {
+                fprintf(file, "%s\"%s\": \"%s\"", j == 0 ? "" : ", ",
+                        result.params[j].first.c_str(), result.params[j].second.c_str());
+            }
+            fprintf(file, "}, \"items_per_sample\": %lld, \"samples\": %d, "
+                          "\"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, \"max_ns\": %.1f, "
+                          "\"ns_per_item\": %.3f, \"items_per_second\": %.1f, \"counters\": {",
+                    result.itemsPerSample, result.samples,
+                    result.minNs, result.medianNs, result.meanNs, result.maxNs,
+                    perItem, perItem > 0.0 ? 1e9 / perItem : 0.0);
+            for (size_t j = 0; j < result.counters.size(); ++j) {
+                fprintf(file, "%s\"%s\": %.3f", j == 0 ? "" : ", ",
+                        result.counters[j].first.c_str(), result.counters[j].second);
+            }
+            fprintf(file, "}}%s\n", i + 1 < results.size() ? "," : "");
+        }
+
+        fprintf(file, "  ]\n}\n");
+        return fclose(file) == 0;
+    }
+};
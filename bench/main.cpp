@@ -0,0 +1,660 @@
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ECS.h"
+#include "Components.h"
+#include "PhysicsSystem.h"
+#include "AnimationSystem.h"
+#include "RenderSnapshot.h"
+#include "DrawQueue.h"
+#include "RenderBackend.h"
+#include "SoftwareRenderer.h"
+#include "RenderSystem.h"
+#include "SceneFile.h"
+#include "SnapshotHistory.h"
+#include "ThreadPool.h"
+#include "WorldStreaming.h"
+#include "Prefab.h"
+#include "AudioManager.h"
+#include "Navigation.h"
+#include "Benchmark.h"
+
+const int SCREEN_WIDTH = 800;
+const int SCREEN_HEIGHT = 600;
+const float STEP_SECONDS = 1.0f / 60.0f;
+
+using Params = std::vector<std::pair<std::string, std::string>>;
+
+Params param(const char* name, long long value) {
+    return Params{{name, std::to_string(value)}};
+}
+
+std::vector<Entity> createEntities(ECS& ecs, int count) {
+    std::vector<Entity> entities;
+    entities.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        entities.push_back(ecs.createEntity());
+    }
+    return entities;
+}
+
+void benchmarkComponentStorage(BenchmarkRunner& runner) {
+    if (!runner.enabledGroup("ecs/")) return;
+
+    for (int count : {1000, 4000}) {
+        std::unique_ptr<ECS> ecs;
+        std::vector<Entity> entities;
+
+        runner.measure("ecs/addComponent", param("entities", count), count, 50,
+            [&] {
+                ecs = std::make_unique<ECS>();
+                entities = createEntities(*ecs, count);
+            },
+            [&] {
+                for (Entity entity : entities) {
+                    ecs->addComponent(entity, Transform{(float)entity, 0.0f, 0.0f, 1.0f, 1.0f});
+                }
+            });
+
+        ecs = std::make_unique<ECS>();
+        entities = createEntities(*ecs, count);
+        for (Entity entity : entities) {
+            ecs->addComponent(entity, Transform{(float)entity, 0.0f, 0.0f, 1.0f, 1.0f});
+        }
+        volatile float sink = 0.0f;
+        runner.measure("ecs/getComponent", param("entities", count), count, 200, nullptr,
+            [&] {
+                float sum = 0.0f;
+                for (Entity entity : entities) {
+                    sum += ecs->getComponent<Transform>(entity).x;
+                }
+                sink = sum;
+            });
+
+        runner.measure("ecs/getEntitiesWithComponent", param("entities", count), count, 200, nullptr,
+            [&] {
+                sink = (float)ecs->getEntitiesWithComponent<Transform>().size();
+            });
+
+        // Removal order is shuffled so the swap-with-last path is exercised
+        // rather than always popping the tail.
+        std::vector<Entity> removalOrder = entities;
+        srand(1234);
+        for (size_t i = removalOrder.size() - 1; i > 0; --i) {
+            std::swap(removalOrder[i], removalOrder[rand() % (i + 1)]);
+        }
+        runner.measure("ecs/removeData", param("entities", count), count, 50,
+            [&] {
+                for (Entity entity : entities) {
+                    ecs->addComponent(entity, Transform{(float)entity, 0.0f, 0.0f, 1.0f, 1.0f});
+                }
+            },
+            [&] {
+                for (Entity entity : removalOrder) {
+                    ecs->removeComponent<Transform>(entity);
+                }
+            });
+    }
+}
+
+void createLevel(ECS& ecs, int count) {
+    for (int i = 0; i < count; ++i) {
+        Entity entity = ecs.createEntity();
+        ecs.addComponent(entity, Transform{(float)(i % 1000) * 64.0f, (float)(i / 1000) * 64.0f, 0.0f, 1.0f, 1.0f});
+        ecs.addComponent(entity, Sprite{nullptr, 64, 64, 0, 0, 0, 0});
+        ecs.addComponent(entity, Collider{64.0f, 64.0f, 0.0f, 0.0f, false});
+        ecs.addComponent(entity, RigidBody{1.0f, false, 0.0f, true});
+    }
+}
+
+// Building a level through addComponent versus mapping it from a scene file
+// with the same four components per entity.
+void benchmarkScenes(BenchmarkRunner& runner) {
+    if (!runner.enabledGroup("scene/")) return;
+
+    const char* path = "bench_scene.bin";
+    SceneRegistry registry = defaultSceneRegistry();
+    SceneTextures textures;
+
+    for (int count : {10000, 100000}) {
+        std::unique_ptr<ECS> ecs;
+        runner.measure("scene/buildWithAddComponent", param("entities", count), count, 10,
+            [&] { ecs = std::make_unique<ECS>(); },
+            [&] { createLevel(*ecs, count); });
+
+        Prefab tile = Prefab("tile")
+            .with(Transform{0.0f, 0.0f, 0.0f, 1.0f, 1.0f})
+            .with(Sprite{nullptr, 64, 64, 0, 0, 0, 0})
+            .with(Collider{64.0f, 64.0f, 0.0f, 0.0f, false})
+            .with(RigidBody{1.0f, false, 0.0f, true});
+        runner.measure("scene/instantiatePrefab", param("entities", count), count, 10,
+            [&] { ecs = std::make_unique<ECS>(); },
+            [&] {
+                instantiate(*ecs, tile, count, [](const PrefabBatch& batch) {
+                    Transform* transforms = batch.components<Transform>();
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        transforms[i].x = (float)(i % 1000) * 64.0f;
+                        transforms[i].y = (float)(i / 1000) * 64.0f;
+                    }
+                });
+            });
+
+        if (ecs == nullptr) {
+            ecs = std::make_unique<ECS>();
+            createLevel(*ecs, count);
+        }
+        std::string error;
+        if (!writeScene(*ecs, registry, textures, path, error)) {
+            printf("Failed to write %s: %s\n", path, error.c_str());
+            return;
+        }
+
+        runner.measure("scene/load", param("entities", count), count, 10,
+            [&] { ecs = std::make_unique<ECS>(); },
+            [&] {
+                if (!loadScene(*ecs, registry, textures, path, error)) {
+                    printf("Failed to load %s: %s\n", path, error.c_str());
+                }
+            });
+    }
+    remove(path);
+}
+
+// A camera panning through the middle of a streamed level 6400 units tall
+// whose width grows with the entity count. The level grows tenfold between
+// sizes; the work per step and the resident entity count should not.
+void benchmarkStreaming(BenchmarkRunner& runner) {
+    if (!runner.enabled("streaming/cameraSweep")) return;
+
+    const char* directory = "bench_level";
+    const int ROWS = 100;
+    SceneRegistry registry = defaultSceneRegistry();
+    SceneTextures textures;
+    ThreadPool pool;
+
+    for (int count : {10000, 100000}) {
+        int columns = count / ROWS;
+        {
+            ECS level;
+            for (int i = 0; i < count; ++i) {
+                Entity entity = level.createEntity();
+                level.addComponent(entity, Transform{(float)(i % columns) * 64.0f, (float)(i / columns) * 64.0f, 0.0f, 1.0f, 1.0f});
+                level.addComponent(entity, Sprite{nullptr, 64, 64, 0, 0, 0, 0});
+                level.addComponent(entity, Collider{64.0f, 64.0f, 0.0f, 0.0f, false});
+                level.addComponent(entity, RigidBody{1.0f, false, 0.0f, true});
+            }
+            std::string error;
+            if (!writeRegionLevel(level, registry, textures, directory, 512, columns * 64, ROWS * 64, error)) {
+                printf("Failed to write %s: %s\n", directory, error.c_str());
+                return;
+            }
+        }
+
+        const int STEPS = 150;
+        std::unique_ptr<ECS> ecs;
+        std::unique_ptr<WorldStreamer> streamer;
+        Camera camera = {0, ROWS * 32.0f, SCREEN_WIDTH, SCREEN_HEIGHT};
+        size_t maxResident = 0;
+        runner.measure("streaming/cameraSweep", param("entities", count), STEPS, 10,
+            [&] {
+                streamer.reset();
+                ecs = std::make_unique<ECS>();
+                streamer = std::make_unique<WorldStreamer>(pool, registry);
+                std::string error;
+                if (!streamer->open(*ecs, directory, textures, error)) {
+                    printf("Failed to open %s: %s\n", directory, error.c_str());
+                }
+                camera.x = 0;
+                streamer->loadAround(*ecs, camera);
+            },
+            [&] {
+                for (int step = 0; step < STEPS; ++step) {
+                    camera.x += 32.0f;
+                    streamer->update(*ecs, camera);
+                    maxResident = std::max<size_t>(maxResident, ecs->entities().livingCount());
+                }
+            });
+        runner.counter("max_resident_entities", (double)maxResident);
+        runner.counter("cached_chunk_bytes", (double)streamer->cachedBytes());
+        streamer.reset();
+    }
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+}
+
+// Bodies are scattered over an area that grows with the count, so the number
+// of overlapping pairs per body stays roughly constant across sizes.
+void createPhysicsScene(ECS& ecs, int bodies) {
+    srand(1234);
+    float side = std::sqrt((float)bodies) * 64.0f;
+
+    Entity ground = ecs.createEntity();
+    ecs.addComponent(ground, Transform{0.0f, side, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(ground, Collider{side, 100.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(ground, RigidBody{1.0f, false, 0.0f, true});
+
+    for (int i = 0; i < bodies; ++i) {
+        Entity body = ecs.createEntity();
+        ecs.addComponent(body, Transform{(float)(rand() % (int)side), (float)(rand() % (int)side), 0.0f, 1.0f, 1.0f});
+        ecs.addComponent(body, Velocity{(float)(rand() % 200 - 100), (float)(rand() % 200 - 100)});
+        ecs.addComponent(body, Collider{32.0f, 32.0f, 0.0f, 0.0f, false});
+        ecs.addComponent(body, RigidBody{1.0f, true, 1.0f, false});
+    }
+}
+
+// Capture and restore of the whole world, and the per-tick cost of keeping a
+// delta-encoded history while every body moves. 20 bodies is roughly
+// the demo scene.
+void benchmarkSnapshots(BenchmarkRunner& runner) {
+    if (!runner.enabledGroup("snapshot/")) return;
+
+    for (int bodies : {20, 1000, 10000}) {
+        ECS ecs;
+        createPhysicsScene(ecs, bodies);
+        // Captured up front so each measure below still has a world to
+        // restore and a history to read when the filter skips the others.
+        WorldSnapshot snapshot;
+        ecs.snapshot(snapshot);
+
+        runner.measure("snapshot/capture", param("bodies", bodies), bodies, 200, nullptr,
+            [&] { ecs.snapshot(snapshot); });
+        runner.counter("snapshot_bytes", (double)snapshot.byteSize());
+
+        runner.measure("snapshot/restore", param("bodies", bodies), bodies, 200, nullptr,
+            [&] { ecs.restore(snapshot); });
+
+        const int TICKS = 120;
+        SnapshotHistory history(TICKS);
+        auto recordHistory = [&] {
+            for (int tick = 0; tick < TICKS; ++tick) {
+                for (Entity entity : ecs.getEntitiesWithComponent<Velocity>(frameArena())) {
+                    Transform& transform = ecs.getComponent<Transform>(entity);
+                    const Velocity& velocity = ecs.getComponent<Velocity>(entity);
+                    transform.x += velocity.vx * STEP_SECONDS;
+                    transform.y += velocity.vy * STEP_SECONDS;
+                }
+                history.push(ecs, tick);
+            }
+        };
+        runner.measure("snapshot/historyPush", param("bodies", bodies), (long long)bodies * TICKS, 3,
+            [&] { ecs.restore(snapshot); }, recordHistory);
+        runner.counter("history_bytes", (double)history.storedBytes());
+        runner.counter("history_retained_bytes", (double)history.retainedBytes());
+        runner.counter("full_copy_bytes", (double)snapshot.byteSize() * TICKS);
+
+        if (history.size() == 0) {
+            ecs.restore(snapshot);
+            recordHistory();
+        }
+        runner.measure("snapshot/historyRestore", param("bodies", bodies), bodies, 50, nullptr,
+            [&] { history.restore(ecs, TICKS - 1 - SnapshotHistory::KEYFRAME_INTERVAL / 2); });
+    }
+}
+
+void benchmarkPhysics(BenchmarkRunner& runner) {
+    struct Size { int bodies; int samples; };
+    for (Size size : {Size{100, 200}, Size{1000, 10}, Size{10000, 2}}) {
+        std::unique_ptr<ECS> ecs;
+        runner.measure("physics/physicsSystem", param("bodies", size.bodies), size.bodies, size.samples,
+            [&] {
+                ecs = std::make_unique<ECS>();
+                createPhysicsScene(*ecs, size.bodies);
+            },
+            [&] {
+                physicsSystem(*ecs, STEP_SECONDS);
+            });
+    }
+}
+
+// Square grids of 8-unit cells with a fixed share of random rectangular
+// obstacles, so the open area and the path lengths grow with the side. The
+// centre, where the benchmarks put the target, is kept clear so it is never
+// walled in.
+void createNavigationGrid(NavGrid& grid, int side) {
+    Random random(1234);
+    float extent = side * 8.0f;
+    float center = extent * 0.5f;
+    grid.reset(extent, extent, 8.0f);
+    for (int i = 0; i < side * side / 400; ++i) {
+        float x = (float)random.below((int)extent);
+        float y = (float)random.below((int)extent);
+        float right = x + 8.0f + (float)random.below(120);
+        float bottom = y + 8.0f + (float)random.below(120);
+        if (x < center + 64.0f && right > center - 64.0f && y < center + 64.0f && bottom > center - 64.0f) continue;
+        grid.block(x, y, right, bottom);
+    }
+}
+
+// A full field rebuild on one thread and spread over the pool, then the
+// per-step cost of steering every agent by one lookup each.
+void benchmarkNavigation(BenchmarkRunner& runner) {
+    if (!runner.enabledGroup("navigation/")) return;
+
+    ThreadPool pool;
+    for (int side : {256, 1024}) {
+        NavGrid grid;
+        createNavigationGrid(grid, side);
+        float center = side * 4.0f;
+        long long cells = (long long)side * side;
+        FlowField field;
+
+        runner.measure("navigation/flowFieldBuild", Params{{"cells", std::to_string(cells)}, {"threads", "1"}},
+            cells, 10, nullptr, [&] { field.build(grid, center, center); });
+        runner.measure("navigation/flowFieldBuild",
+            Params{{"cells", std::to_string(cells)}, {"threads", std::to_string(pool.threadCount() + 1)}},
+            cells, 10, nullptr, [&] { field.build(grid, center, center, &pool); });
+
+        if (runner.enabled("navigation/flowFieldBuild")) {
+            long long reached = 0;
+            for (long long cell = 0; cell < cells; ++cell) {
+                if (field.distance((int)cell) != FlowField::UNREACHABLE) ++reached;
+            }
+            runner.counter("reached_cells", (double)reached);
+        }
+    }
+
+    NavGrid grid;
+    createNavigationGrid(grid, 256);
+    FlowField field;
+    field.build(grid, 1024.0f, 1024.0f);
+    for (int agents : {1000, 10000}) {
+        ECS ecs;
+        Random random(1234);
+        for (int i = 0; i < agents; ++i) {
+            Entity agent = ecs.createEntity();
+            ecs.addComponent(agent, Transform{(float)random.below(2048), (float)random.below(2048), 0.0f, 1.0f, 1.0f});
+            ecs.addComponent(agent, Velocity{0.0f, 0.0f});
+            ecs.addComponent(agent, NavAgent{120.0f, 4.0f});
+        }
+        runner.measure("navigation/steer", param("agents", agents), agents, 200, nullptr,
+            [&] { flowFieldSteeringSystem(ecs, field); });
+    }
+}
+
+// Bursts of positional sound events on the dummy audio driver, with more
+// events than voices so most of them go through voice stealing.
+void benchmarkAudio(BenchmarkRunner& runner) {
+    if (!runner.enabled("audio/playBurst")) return;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0 || Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+        printf("Audio could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return;
+    }
+
+    std::vector<Uint8> samples(44100 * 4, 0);
+    SoundAsset sound;
+    sound.chunk = Mix_QuickLoad_RAW(samples.data(), (Uint32)samples.size());
+    sound.state = AssetState::Ready;
+
+    {
+        AudioManager audio;
+        audio.setListener(Camera{0.0f, 0.0f, SCREEN_WIDTH, SCREEN_HEIGHT});
+        for (int events : {16, 256}) {
+            std::uint64_t stolenBefore = 0;
+            std::uint64_t droppedBefore = 0;
+            runner.measure("audio/playBurst", param("events", events), events, 50,
+                [&] {
+                    audio.stopAll();
+                    stolenBefore = audio.stolenCount();
+                    droppedBefore = audio.droppedCount();
+                },
+                [&] {
+                    for (int i = 0; i < events; ++i) {
+                        float x = (float)((i * 37) % 1600);
+                        audio.play(&sound, SoundParams{i % 4, 1.0f, true, x, 300.0f});
+                    }
+                });
+            runner.counter("voices", (double)audio.voiceCount());
+            runner.counter("stolen_per_burst", (double)(audio.stolenCount() - stolenBefore));
+            runner.counter("dropped_per_burst", (double)(audio.droppedCount() - droppedBefore));
+        }
+        audio.stopAll();
+    }
+
+    Mix_FreeChunk(sound.chunk.load());
+    Mix_CloseAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+// Every emitter fires once per tick and each particle lives 0.5 s, so after
+// the warm-up the scene holds a steady 30 particles per emitter with as many
+// spawned as expired every tick.
+void benchmarkParticles(BenchmarkRunner& runner) {
+    const int TICKS = 60;
+    for (int emitters : {50, 400}) {
+        if (!runner.enabled("particles/churn")) continue;
+
+        std::unique_ptr<ECS> ecs;
+        std::unique_ptr<ExpiryWheel> expiryWheel;
+        Random random;
+        runner.measure("particles/churn", param("emitters", emitters), (long long)emitters * TICKS, 10,
+            [&] {
+                random = Random(1234);
+                ecs = std::make_unique<ECS>();
+                expiryWheel = std::make_unique<ExpiryWheel>();
+                for (int i = 0; i < emitters; ++i) {
+                    Entity emitter = ecs->createEntity();
+                    ecs->addComponent(emitter, Transform{(float)(i * 10), 0.0f, 0.0f, 1.0f, 1.0f});
+                    ecs->addComponent(emitter, ParticleEmitter{
+                        120.0f, 0.5f, 0.0f, 50, true,
+                        -50.0f, 50.0f, -100.0f, -50.0f
+                    });
+                }
+                for (int tick = 0; tick < TICKS; ++tick) {
+                    particleSystem(*ecs, *expiryWheel, random, STEP_SECONDS);
+                    expirySystem(*ecs, *expiryWheel, STEP_SECONDS);
+                }
+            },
+            [&] {
+                for (int tick = 0; tick < TICKS; ++tick) {
+                    particleSystem(*ecs, *expiryWheel, random, STEP_SECONDS);
+                    expirySystem(*ecs, *expiryWheel, STEP_SECONDS);
+                }
+            });
+        runner.counter("live_particles", (double)ecs->getEntitiesWithComponent<Particle>().size());
+    }
+}
+
+void benchmarkAnimation(BenchmarkRunner& runner) {
+    AnimationClipTable clips;
+    std::vector<AnimationClipHandle> handles = {
+        clips.addClip("idle", nullptr, 64, 64, 8, 0, 4, 0.2f, true),
+        clips.addClip("run", nullptr, 64, 64, 8, 8, 8, 0.08f, true),
+        clips.addClip("attack", nullptr, 64, 64, 8, 16, 6, 0.05f, false)
+    };
+
+    for (int count : {1000, 10000}) {
+        if (!runner.enabled("animation/animationSystem")) continue;
+
+        ECS ecs;
+        srand(1234);
+        for (int i = 0; i < count; ++i) {
+            Entity entity = ecs.createEntity();
+            ecs.addComponent(entity, Sprite{nullptr, 64, 64, 0, 0, 0, 0});
+            Animation animation = makeAnimation(handles[i % handles.size()]);
+            animation.elapsedTime = (float)(rand() % 100) / 1000.0f;
+            ecs.addComponent(entity, animation);
+        }
+
+        runner.measure("animation/animationSystem", param("entities", count), count, 100, nullptr,
+            [&] {
+                animationSystem(ecs, clips, STEP_SECONDS);
+            });
+    }
+}
+
+void* createBenchmarkTexture(RenderBackend& backend) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == nullptr) return nullptr;
+    SDL_FillRect(surface, NULL, 0xFF4080C0u);
+    void* texture = backend.createTexture(surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+// Half sprites, half particles, spread over one screen so every draw lands.
+void createRenderScene(ECS& ecs, void* texture, int draws, Entity& player) {
+    srand(1234);
+    player = ecs.createEntity();
+    ecs.addComponent(player, Transform{0.0f, 0.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(player, Health{100, 100});
+
+    for (int i = 0; i < draws; ++i) {
+        Entity entity = ecs.createEntity();
+        ecs.addComponent(entity, Transform{(float)(rand() % SCREEN_WIDTH), (float)(rand() % SCREEN_HEIGHT),
+                                           0.0f, 0.5f, 0.5f});
+        if (i % 2 == 0) {
+            ecs.addComponent(entity, Sprite{texture, 64, 64, 0, 0, 0, 0});
+        } else {
+            ecs.addComponent(entity, Particle{1.0f, 0.0f, 255, 200, 100, 255});
+        }
+    }
+}
+
+void benchmarkRenderBackend(BenchmarkRunner& runner, RenderBackend& backend, const char* driver) {
+    void* texture = createBenchmarkTexture(backend);
+    Camera camera = {0.0f, 0.0f, SCREEN_WIDTH, SCREEN_HEIGHT};
+
+    for (int draws : {1000, 4000}) {
+        ECS ecs;
+        Entity player;
+        createRenderScene(ecs, texture, draws, player);
+
+        RenderSnapshot snapshot;
+        DrawQueue drawQueue;
+        Params params = {{"driver", driver}, {"draws", std::to_string(draws)}};
+
+        runner.measure("render/buildRenderSnapshot", params, draws, 50, nullptr,
+            [&] {
+                buildRenderSnapshot(ecs, player, 0.5f, snapshot);
+            });
+
+        buildRenderSnapshot(ecs, player, 0.5f, snapshot);
+        runner.measure("render/drawQueue", params, draws, 100, nullptr,
+            [&] {
+                drawQueue.build(snapshot, false);
+            });
+
+        drawQueue.build(snapshot, false);
+        runner.measure("render/renderSystem", params, draws, 50,
+            [&] {
+                backend.setDrawColor(30, 30, 46, 255);
+                backend.clear();
+            },
+            [&] {
+                renderSystem(drawQueue, snapshot, backend, camera, 1.0f);
+            });
+    }
+
+    backend.destroyTexture(texture);
+}
+
+// SDL's dummy video driver has no GPU, so SDL's own software renderer stands
+// in for the accelerated path; the CPU rasterizer needs no window at all.
+void benchmarkRendering(BenchmarkRunner& runner) {
+    if (!runner.enabledGroup("render/")) return;
+
+    {
+        SoftwareRenderBackend backend(SCREEN_WIDTH, SCREEN_HEIGHT);
+        benchmarkRenderBackend(runner, backend, "cpu-rasterizer");
+    }
+
+    SDL_Window* window = SDL_CreateWindow("GameEngineBench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                          SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_HIDDEN);
+    if (window == nullptr) {
+        printf("Skipping SDL renderer benchmarks: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    if (renderer == nullptr) {
+        printf("Skipping SDL renderer benchmarks: %s\n", SDL_GetError());
+        SDL_DestroyWindow(window);
+        return;
+    }
+
+    {
+        SDLRenderBackend backend(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+        benchmarkRenderBackend(runner, backend, "sdl-software");
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+}
+
+#undef main
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string outputPath = "bench_results.json";
+    double sampleScale = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--quick") {
+            sampleScale = 0.2;
+        } else {
+            printf("Usage: GameEngineBench [--filter <substring>] [--out <path>] [--quick]\n");
+            return 1;
+        }
+    }
+
+    if (getenv("SDL_VIDEODRIVER") == nullptr) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    BenchmarkRunner runner(filter, sampleScale);
+    benchmarkComponentStorage(runner);
+    benchmarkScenes(runner);
+    benchmarkSnapshots(runner);
+    benchmarkStreaming(runner);
+    benchmarkPhysics(runner);
+    benchmarkNavigation(runner);
+    benchmarkParticles(runner);
+    benchmarkAudio(runner);
+    benchmarkAnimation(runner);
+    benchmarkRendering(runner);
+
+    char timestamp[32];
+    time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+
+    std::vector<std::pair<std::string, std::string>> context = {
+        {"timestamp", timestamp},
+        {"build", buildType},
+        {"max_entities", std::to_string(MAX_ENTITIES)},
+        {"video_driver", SDL_GetCurrentVideoDriver() ? SDL_GetCurrentVideoDriver() : "none"},
+        {"cpu_count", std::to_string(SDL_GetCPUCount())}
+    };
+
+    if (!runner.writeJson(outputPath.c_str(), context)) {
+        printf("Failed to write %s\n", outputPath.c_str());
+        SDL_Quit();
+        return 1;
+    }
+    printf("Wrote %s\n", outputPath.c_str());
+
+    SDL_Quit();
+    return 0;
+}
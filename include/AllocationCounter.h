@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts global operator new/delete calls per thread, so each loop can report
+// how many heap allocations its own frame or step made, and keeps process-wide
+// live and peak byte totals. Include from exactly one translation unit per
+// program: it replaces the global allocation functions. Array and nothrow
+// forms forward to these in the standard library.
+struct AllocationCounts {
+    std::uint64_t allocations;
+    std::uint64_t frees;
+    std::uint64_t bytes;
+};
+
+AllocationCounts& threadAllocationCounts() {
+    static thread_local AllocationCounts counts{0, 0, 0};
+    return counts;
+}
+
+struct HeapCounters {
+    std::atomic<std::int64_t> liveBytes{0};
+    std::atomic<std::int64_t> peakBytes{0};
+    std::atomic<std::uint64_t> allocations{0};
+};
+
+HeapCounters& heapCounters() {
+    static HeapCounters counters;
+    return counters;
+}
+
+// Each block carries its size in a header so frees can be subtracted from the
+// live total; the header is max_align_t wide to keep the returned pointer
+// aligned the way malloc's would be.
+constexpr std::size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+
+void* operator new(std::size_t size) {
+    AllocationCounts& counts = threadAllocationCounts();
+    ++counts.allocations;
+    counts.bytes += size;
+
+    void* block = std::malloc(size + ALLOCATION_HEADER_SIZE);
+    if (block == nullptr) throw std::bad_alloc();
+    *(std::size_t*)block = size;
+
+    HeapCounters& heap = heapCounters();
+    heap.allocations.fetch_add(1, std::memory_order_relaxed);
+    std::int64_t live = heap.liveBytes.fetch_add((std::int64_t)size, std::memory_order_relaxed) + (std::int64_t)size;
+    std::int64_t peak = heap.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !heap.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+
+    return (std::uint8_t*)block + ALLOCATION_HEADER_SIZE;
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory == nullptr) return;
+    ++threadAllocationCounts().frees;
+
+    void* block = (std::uint8_t*)memory - ALLOCATION_HEADER_SIZE;
+    heapCounters().liveBytes.fetch_sub((std::int64_t)*(std::size_t*)block, std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
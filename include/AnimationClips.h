@@ -0,0 +1,73 @@
+#pragma once
+#include "Components.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AnimationFrame {
+    int srcX;
+    int srcY;
+    float duration;
+};
+
+// Clip definitions are shared: every Animation instance playing a clip refers
+// to it by handle and only carries its own playback state.
+struct AnimationClip {
+    std::string name;
+    void* spriteSheet;
+    int frameWidth;
+    int frameHeight;
+    bool loop;
+    std::vector<AnimationFrame> frames;
+};
+
+class AnimationClipTable {
+private:
+    static constexpr float MIN_FRAME_DURATION = 0.001f;
+
+    std::vector<AnimationClip> clips;
+    std::unordered_map<std::string, AnimationClipHandle> handlesByName;
+
+public:
+    // Frames are read row-major from a sheet `columns` frames wide, starting
+    // at frame index `firstFrame`, so one sheet can hold several clips.
+    AnimationClipHandle addClip(const std::string& name, void* spriteSheet, int frameWidth, int frameHeight,
+                                int columns, int firstFrame, const std::vector<float>& frameDurations, bool loop) {
+        AnimationClip clip{name, spriteSheet, frameWidth, frameHeight, loop, {}};
+        clip.frames.reserve(frameDurations.size());
+
+        for (size_t i = 0; i < frameDurations.size(); ++i) {
+            int frameIndex = firstFrame + (int)i;
+            clip.frames.push_back(AnimationFrame{
+                (frameIndex % columns) * frameWidth,
+                (frameIndex / columns) * frameHeight,
+                std::max(frameDurations[i], MIN_FRAME_DURATION)
+            });
+        }
+
+        AnimationClipHandle handle = (AnimationClipHandle)clips.size();
+        clips.push_back(std::move(clip));
+        handlesByName[name] = handle;
+        return handle;
+    }
+
+    AnimationClipHandle addClip(const std::string& name, void* spriteSheet, int frameWidth, int frameHeight,
+                                int columns, int firstFrame, int frameCount, float frameTime, bool loop) {
+        return addClip(name, spriteSheet, frameWidth, frameHeight, columns, firstFrame,
+                       std::vector<float>(frameCount, frameTime), loop);
+    }
+
+    const AnimationClip& getClip(AnimationClipHandle handle) const {
+        return clips[handle];
+    }
+
+    bool findClip(const std::string& name, AnimationClipHandle& handle) const {
+        auto it = handlesByName.find(name);
+        if (it == handlesByName.end()) {
+            return false;
+        }
+        handle = it->second;
+        return true;
+    }
+};
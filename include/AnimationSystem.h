@@ -1,51 +1,106 @@
 #pragma once
 #include "ECS.h"
 #include "Components.h"
+#include "AnimationClips.h"
+#include "ExpiryWheel.h"
+#include "Prefab.h"
+#include "Random.h"
 #include <SDL.h>
 
-void animationSystem(ECS& ecs, float deltaTime) {
-    auto entities = ecs.getEntitiesWithComponent<Animation>();
+Animation makeAnimation(AnimationClipHandle clip) {
+    return Animation{clip, 0, 0.0f, true, -1};
+}
+
+void playAnimation(Animation& animation, AnimationClipHandle clip) {
+    animation.clip = clip;
+    animation.currentFrame = 0;
+    animation.elapsedTime = 0.0f;
+    animation.playing = true;
+    animation.appliedFrame = -1;
+}
+
+void animationSystem(ECS& ecs, const AnimationClipTable& clips, float deltaTime) {
+    auto entities = ecs.getEntitiesWithComponent<Animation>(frameArena());
 
     for (Entity entity : entities) {
         if (!ecs.hasComponent<Sprite>(entity)) continue;
 
         auto& animation = ecs.getComponent<Animation>(entity);
-        auto& sprite = ecs.getComponent<Sprite>(entity);
-
-        if (!animation.playing) continue;
-
-        animation.elapsedTime += deltaTime;
-
-        if (animation.elapsedTime >= animation.frameTime) {
-            animation.elapsedTime = 0.0f;
-            animation.currentFrame++;
-
-            if (animation.currentFrame >= animation.totalFrames) {
-                if (animation.loop) {
-                    animation.currentFrame = 0;
-                } else {
-                    animation.currentFrame = animation.totalFrames - 1;
-                    animation.playing = false;
+        const AnimationClip& clip = clips.getClip(animation.clip);
+        const int totalFrames = (int)clip.frames.size();
+        if (totalFrames == 0) continue;
+
+        if (animation.playing) {
+            animation.elapsedTime += deltaTime;
+
+            // Leftover time carries into the next frame, so a long delta
+            // steps through as many frames as it covers.
+            while (animation.elapsedTime >= clip.frames[animation.currentFrame].duration) {
+                animation.elapsedTime -= clip.frames[animation.currentFrame].duration;
+                animation.currentFrame++;
+
+                if (animation.currentFrame >= totalFrames) {
+                    if (clip.loop) {
+                        animation.currentFrame = 0;
+                    } else {
+                        animation.currentFrame = totalFrames - 1;
+                        animation.elapsedTime = 0.0f;
+                        animation.playing = false;
+                        break;
+                    }
                 }
             }
         }
 
-        sprite.texture = animation.spriteSheet;
-        sprite.srcX = animation.currentFrame * animation.frameWidth;
-        sprite.srcY = 0;
-        sprite.srcWidth = animation.frameWidth;
-        sprite.srcHeight = animation.frameHeight;
+        if (animation.currentFrame == animation.appliedFrame) continue;
+
+        const AnimationFrame& frame = clip.frames[animation.currentFrame];
+        auto& sprite = ecs.getComponent<Sprite>(entity);
+        sprite.texture = clip.spriteSheet;
+        sprite.asset = nullptr;
+        sprite.srcX = frame.srcX;
+        sprite.srcY = frame.srcY;
+        sprite.srcWidth = clip.frameWidth;
+        sprite.srcHeight = clip.frameHeight;
+        animation.appliedFrame = animation.currentFrame;
     }
 }
 
-void particleSystem(ECS& ecs, float deltaTime) {
-    auto emitters = ecs.getEntitiesWithComponent<ParticleEmitter>();
+float particleExpiryTime(const Particle& particle) {
+    return particle.spawnTime + particle.lifetime;
+}
+
+float lifetimeExpiryTime(const Lifetime& lifetime) {
+    return lifetime.spawnTime + lifetime.duration;
+}
+
+// Alpha is derived from spawn time when drawn instead of being stored back
+// into every particle each tick.
+int particleAlpha(const Particle& particle, float now) {
+    float lifeRatio = (now - particle.spawnTime) / particle.lifetime;
+    if (lifeRatio < 0.0f) lifeRatio = 0.0f;
+    if (lifeRatio > 1.0f) lifeRatio = 1.0f;
+    return (int)(particle.colorA * (1.0f - lifeRatio));
+}
+
+const Prefab& particlePrefab() {
+    static const Prefab prefab = Prefab("particle")
+        .with(Transform{0.0f, 0.0f, 0.0f, 0.3f, 0.3f})
+        .with(Velocity{0.0f, 0.0f})
+        .with(Particle{0.0f, 0.0f, 255, 200, 100, 255});
+    return prefab;
+}
+
+// Emitters that are due this step are collected first, so all of the step's
+// particles go into the pools as one batch.
+void particleSystem(ECS& ecs, ExpiryWheel& expiryWheel, Random& random, float deltaTime) {
+    auto emitters = ecs.getEntitiesWithComponent<ParticleEmitter>(frameArena());
+    auto dueEmitters = makeFrameVector<Entity>(frameArena(), emitters.size());
 
     for (Entity emitter : emitters) {
         if (!ecs.hasComponent<Transform>(emitter)) continue;
 
         auto& particleEmitter = ecs.getComponent<ParticleEmitter>(emitter);
-        auto& emitterTransform = ecs.getComponent<Transform>(emitter);
 
         if (!particleEmitter.active) continue;
 
@@ -53,70 +108,92 @@ void particleSystem(ECS& ecs, float deltaTime) {
 
         if (particleEmitter.timeSinceLastEmit >= 1.0f / particleEmitter.emissionRate) {
             particleEmitter.timeSinceLastEmit = 0.0f;
+            dueEmitters.push_back(emitter);
+        }
+    }
+    if (dueEmitters.empty()) return;
+
+    instantiate(ecs, particlePrefab(), dueEmitters.size(), [&](const PrefabBatch& batch) {
+        Transform* transforms = batch.components<Transform>();
+        Velocity* velocities = batch.components<Velocity>();
+        Particle* particles = batch.components<Particle>();
 
-            Entity particle = ecs.createEntity();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto& particleEmitter = ecs.getComponent<ParticleEmitter>(dueEmitters[i]);
+            auto& emitterTransform = ecs.getComponent<Transform>(dueEmitters[i]);
 
             float vx = particleEmitter.minVelocityX + 
-                      (float)(rand() % 100) / 100.0f * 
+                      (float)random.below(100) / 100.0f * 
                       (particleEmitter.maxVelocityX - particleEmitter.minVelocityX);
             float vy = particleEmitter.minVelocityY + 
-                      (float)(rand() % 100) / 100.0f * 
+                      (float)random.below(100) / 100.0f * 
                       (particleEmitter.maxVelocityY - particleEmitter.minVelocityY);
 
-            ecs.addComponent(particle, Transform{
-                emitterTransform.x, 
-                emitterTransform.y, 
-                0.0f, 
-                0.3f, 
-                0.3f
-            });
-            ecs.addComponent(particle, Velocity{vx, vy});
-            ecs.addComponent(particle, Particle{
-                particleEmitter.particleLifetime,
-                0.0f,
-                255, 200, 100, 255
-            });
+            transforms[i].x = emitterTransform.x;
+            transforms[i].y = emitterTransform.y;
+            velocities[i] = Velocity{vx, vy};
+            particles[i].lifetime = particleEmitter.particleLifetime;
+            particles[i].spawnTime = expiryWheel.time();
+            expiryWheel.schedule(batch.entity(i), particleExpiryTime(particles[i]));
         }
-    }
-
-    auto particles = ecs.getEntitiesWithComponent<Particle>();
-    std::vector<Entity> toDestroy;
-
-    for (Entity entity : particles) {
-        if (!ecs.hasComponent<Transform>(entity)) continue;
-
-        auto& particle = ecs.getComponent<Particle>(entity);
-        
-        particle.age += deltaTime;
+    });
+}
 
-        if (particle.age >= particle.lifetime) {
-            toDestroy.push_back(entity);
-            continue;
-        }
+void addLifetime(ECS& ecs, ExpiryWheel& expiryWheel, Entity entity, float duration) {
+    Lifetime lifetime{duration, expiryWheel.time()};
+    ecs.addComponent(entity, lifetime);
+    expiryWheel.schedule(entity, lifetimeExpiryTime(lifetime));
+}
 
-        float lifeRatio = particle.age / particle.lifetime;
-        particle.colorA = (int)(255 * (1.0f - lifeRatio));
+// Schedules every Particle and Lifetime entity with the wheel, for worlds the
+// wheel has not seen being created: loaded from a scene file, or restored
+// from a snapshot after the wheel was reset. Loaded entities restart their
+// lifetimes from the wheel's current time; restored ones keep their own.
+void scheduleExpiries(ECS& ecs, ExpiryWheel& expiryWheel, bool restartLifetimes) {
+    for (Entity entity : ecs.getEntitiesWithComponent<Particle>(frameArena())) {
+        Particle& particle = ecs.getComponent<Particle>(entity);
+        if (restartLifetimes) particle.spawnTime = expiryWheel.time();
+        expiryWheel.schedule(entity, particleExpiryTime(particle));
     }
-
-    for (Entity entity : toDestroy) {
-        ecs.destroyEntity(entity);
+    for (Entity entity : ecs.getEntitiesWithComponent<Lifetime>(frameArena())) {
+        Lifetime& lifetime = ecs.getComponent<Lifetime>(entity);
+        if (restartLifetimes) lifetime.spawnTime = expiryWheel.time();
+        expiryWheel.schedule(entity, lifetimeExpiryTime(lifetime));
     }
 }
 
-void lifetimeSystem(ECS& ecs, float deltaTime) {
-    auto entities = ecs.getEntitiesWithComponent<Lifetime>();
-    std::vector<Entity> toDestroy;
-
-    for (Entity entity : entities) {
-        auto& lifetime = ecs.getComponent<Lifetime>(entity);
-        lifetime.elapsed += deltaTime;
+// The same for just the given entities, e.g. those a WorldStreamer update
+// brought back in. They keep their own spawn times, so one whose time ran out
+// while its region was unloaded expires on the next tick.
+void scheduleExpiries(ECS& ecs, ExpiryWheel& expiryWheel, const Entity* entities, size_t count) {
+    auto& particles = ecs.pool<Particle>();
+    auto& lifetimes = ecs.pool<Lifetime>();
+    for (size_t i = 0; i < count; ++i) {
+        Entity entity = entities[i];
+        if (particles.hasData(entity)) expiryWheel.schedule(entity, particleExpiryTime(particles.getData(entity)));
+        if (lifetimes.hasData(entity)) expiryWheel.schedule(entity, lifetimeExpiryTime(lifetimes.getData(entity)));
+    }
+}
 
-        if (lifetime.elapsed >= lifetime.duration) {
-            toDestroy.push_back(entity);
+// Particles and Lifetime entities are registered with the wheel when created,
+// so only the entities that actually expire this tick are touched here. Entity
+// IDs are recycled, so each due entry is checked against the live component
+// before the entity is destroyed.
+void expirySystem(ECS& ecs, ExpiryWheel& expiryWheel, float deltaTime) {
+    for (const ExpiryWheel::Entry& entry : expiryWheel.advance(deltaTime)) {
+        bool expired = false;
+
+        if (ecs.hasComponent<Particle>(entry.entity)) {
+            auto& particle = ecs.getComponent<Particle>(entry.entity);
+            expired = expiryWheel.tickFor(particleExpiryTime(particle)) <= entry.tick;
+        }
+        if (!expired && ecs.hasComponent<Lifetime>(entry.entity)) {
+            auto& lifetime = ecs.getComponent<Lifetime>(entry.entity);
+            expired = expiryWheel.tickFor(lifetimeExpiryTime(lifetime)) <= entry.tick;
         }
-    }
 
-    for (Entity entity : toDestroy) {
-        ecs.destroyEntity(entity);
+        if (expired) {
+            ecs.destroyEntity(entry.entity);
+        }
     }
-}
\ No newline at end of file
+}
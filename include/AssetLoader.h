@@ -0,0 +1,313 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+#include "RenderBackend.h"
+#include "TextureAsset.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Short sounds are decoded into chunk; files larger than the loader's
+// stream threshold are opened as stream instead and decoded while playing.
+struct SoundAsset {
+    std::string path;
+    std::atomic<Mix_Chunk*> chunk{nullptr};
+    std::atomic<Mix_Music*> stream{nullptr};
+    std::atomic<AssetState> state{AssetState::Pending};
+};
+
+// TTF_OpenFontRW reads from the file bytes for as long as the font is open,
+// so the asset keeps them.
+struct FontAsset {
+    std::string path;
+    int pointSize = 0;
+    std::vector<std::uint8_t> fileBytes;
+    TTF_Font* font = nullptr;
+    std::atomic<AssetState> state{AssetState::Pending};
+
+    TTF_Font* readyFont() const {
+        return state.load(std::memory_order_acquire) == AssetState::Ready ? font : nullptr;
+    }
+};
+
+// Loads textures, sounds and fonts without blocking the caller. Requests
+// return a handle immediately; file reads and PNG/WAV decoding run on the
+// thread pool, and everything that must happen on the main thread (texture
+// upload, font creation) is queued for processCompletions. Requests for a
+// path that is already loaded or in flight return the existing handle.
+// Handles stay valid for the loader's lifetime.
+class AssetLoader {
+private:
+    enum class CompletionKind : std::uint8_t {
+        Texture,
+        Sound,
+        Font
+    };
+
+    struct Completion {
+        CompletionKind kind;
+        void* asset;
+        SDL_Surface* surface;
+        Mix_Chunk* chunk;
+        Mix_Music* stream;
+    };
+
+    ThreadPool& pool;
+    RenderBackend& backend;
+    void* placeholder = nullptr;
+
+    std::deque<std::unique_ptr<TextureAsset>> textures;
+    std::deque<std::unique_ptr<SoundAsset>> sounds;
+    std::deque<std::unique_ptr<FontAsset>> fonts;
+    std::unordered_map<std::string, TextureAsset*> texturesByPath;
+    std::unordered_map<std::string, SoundAsset*> soundsByPath;
+    std::unordered_map<std::string, FontAsset*> fontsByKey;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+    std::vector<Completion> draining;
+    std::atomic<int> inFlight{0};
+    size_t soundStreamThreshold = 1024 * 1024;
+
+    void complete(Completion completion) {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        completions.push_back(completion);
+    }
+
+    // Magenta/black checkerboard, so a texture that never arrives is obvious.
+    void createPlaceholder() {
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA32);
+        if (surface == nullptr) return;
+        for (int y = 0; y < 8; ++y) {
+            Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+            for (int x = 0; x < 8; ++x) {
+                bool magenta = ((x / 4) + (y / 4)) % 2 == 0;
+                row[x] = magenta ? SDL_MapRGBA(surface->format, 255, 0, 255, 255)
+                                 : SDL_MapRGBA(surface->format, 0, 0, 0, 255);
+            }
+        }
+        placeholder = backend.createTexture(surface);
+        SDL_FreeSurface(surface);
+    }
+
+public:
+    AssetLoader(ThreadPool& pool, RenderBackend& backend) : pool(pool), backend(backend) {
+        createPlaceholder();
+    }
+
+    // Waits for in-flight decodes, since they hold a pointer to the loader.
+    // Must run before the backend, SDL_mixer and SDL_ttf are shut down.
+    ~AssetLoader() {
+        pool.waitIdle();
+        processCompletions();
+
+        for (auto& texture : textures) {
+            void* loaded = texture->texture.load();
+            if (loaded != placeholder) backend.destroyTexture(loaded);
+        }
+        for (auto& sound : sounds) {
+            if (sound->chunk.load() != nullptr) Mix_FreeChunk(sound->chunk.load());
+            if (sound->stream.load() != nullptr) Mix_FreeMusic(sound->stream.load());
+        }
+        for (auto& font : fonts) {
+            if (font->font != nullptr) TTF_CloseFont(font->font);
+        }
+        backend.destroyTexture(placeholder);
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void* placeholderTexture() const {
+        return placeholder;
+    }
+
+    const TextureAsset* loadTexture(const std::string& path) {
+        auto existing = texturesByPath.find(path);
+        if (existing != texturesByPath.end()) return existing->second;
+
+        textures.push_back(std::make_unique<TextureAsset>());
+        TextureAsset* asset = textures.back().get();
+        asset->path = path;
+        asset->texture.store(placeholder, std::memory_order_release);
+        texturesByPath[path] = asset;
+
+        ++inFlight;
+        pool.submit([this, asset] {
+            PROFILE_SCOPE("decodeTexture");
+            SDL_Surface* surface = IMG_Load(asset->path.c_str());
+            if (surface == nullptr) {
+                std::cout << "Unable to load image " << asset->path << "! SDL_image Error: " << IMG_GetError() << std::endl;
+            }
+            complete(Completion{CompletionKind::Texture, asset, surface, nullptr, nullptr});
+        });
+        return asset;
+    }
+
+    // Sound files above this size are streamed rather than decoded up front.
+    // Applies to sounds requested after the call.
+    void setSoundStreamThreshold(size_t bytes) {
+        soundStreamThreshold = bytes;
+    }
+
+    const SoundAsset* loadSound(const std::string& path) {
+        auto existing = soundsByPath.find(path);
+        if (existing != soundsByPath.end()) return existing->second;
+
+        sounds.push_back(std::make_unique<SoundAsset>());
+        SoundAsset* asset = sounds.back().get();
+        asset->path = path;
+        soundsByPath[path] = asset;
+
+        ++inFlight;
+        size_t streamThreshold = soundStreamThreshold;
+        pool.submit([this, asset, streamThreshold] {
+            PROFILE_SCOPE("decodeSound");
+            std::error_code ignored;
+            std::uintmax_t fileSize = std::filesystem::file_size(asset->path, ignored);
+            Mix_Chunk* chunk = nullptr;
+            Mix_Music* stream = nullptr;
+            if (!ignored && fileSize > streamThreshold) {
+                stream = Mix_LoadMUS(asset->path.c_str());
+            } else {
+                chunk = Mix_LoadWAV(asset->path.c_str());
+            }
+            if (chunk == nullptr && stream == nullptr) {
+                std::cout << "Failed to load sound " << asset->path << "! SDL_mixer Error: " << Mix_GetError() << std::endl;
+            }
+            complete(Completion{CompletionKind::Sound, asset, nullptr, chunk, stream});
+        });
+        return asset;
+    }
+
+    // Only the file read happens on a worker: FreeType faces share one
+    // library object and are created on the main thread.
+    const FontAsset* loadFont(const std::string& path, int pointSize) {
+        std::string key = path + "@" + std::to_string(pointSize);
+        auto existing = fontsByKey.find(key);
+        if (existing != fontsByKey.end()) return existing->second;
+
+        fonts.push_back(std::make_unique<FontAsset>());
+        FontAsset* asset = fonts.back().get();
+        asset->path = path;
+        asset->pointSize = pointSize;
+        fontsByKey[key] = asset;
+
+        ++inFlight;
+        pool.submit([this, asset] {
+            PROFILE_SCOPE("readFont");
+            size_t size = 0;
+            void* data = SDL_LoadFile(asset->path.c_str(), &size);
+            if (data != nullptr) {
+                asset->fileBytes.assign((std::uint8_t*)data, (std::uint8_t*)data + size);
+                SDL_free(data);
+            }
+            complete(Completion{CompletionKind::Font, asset, nullptr, nullptr, nullptr});
+        });
+        return asset;
+    }
+
+    // Main thread only. Uploads up to maxUploads finished textures (each is
+    // a driver call proportional to the image size) and publishes finished
+    // sounds and fonts; the rest wait for the next call so a burst of
+    // completions is spread over several frames. Returns how many finished.
+    int processCompletions(int maxUploads = -1) {
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            if (completions.empty()) return 0;
+            draining.swap(completions);
+        }
+
+        int finished = 0;
+        int uploads = 0;
+        size_t i = 0;
+        for (; i < draining.size(); ++i) {
+            Completion& completion = draining[i];
+            if (completion.kind == CompletionKind::Texture && maxUploads >= 0 && uploads >= maxUploads) break;
+
+            switch (completion.kind) {
+                case CompletionKind::Texture: {
+                    PROFILE_SCOPE("uploadTexture");
+                    TextureAsset* asset = (TextureAsset*)completion.asset;
+                    void* texture = completion.surface != nullptr ? backend.createTexture(completion.surface) : nullptr;
+                    if (completion.surface != nullptr) SDL_FreeSurface(completion.surface);
+                    if (texture != nullptr) {
+                        asset->texture.store(texture, std::memory_order_release);
+                        asset->state.store(AssetState::Ready, std::memory_order_release);
+                    } else {
+                        asset->state.store(AssetState::Failed, std::memory_order_release);
+                    }
+                    ++uploads;
+                    break;
+                }
+                case CompletionKind::Sound: {
+                    SoundAsset* asset = (SoundAsset*)completion.asset;
+                    asset->chunk.store(completion.chunk, std::memory_order_release);
+                    asset->stream.store(completion.stream, std::memory_order_release);
+                    bool loaded = completion.chunk != nullptr || completion.stream != nullptr;
+                    asset->state.store(loaded ? AssetState::Ready : AssetState::Failed, std::memory_order_release);
+                    break;
+                }
+                case CompletionKind::Font: {
+                    FontAsset* asset = (FontAsset*)completion.asset;
+                    if (!asset->fileBytes.empty()) {
+                        SDL_RWops* file = SDL_RWFromConstMem(asset->fileBytes.data(), (int)asset->fileBytes.size());
+                        asset->font = TTF_OpenFontRW(file, 1, asset->pointSize);
+                    }
+                    if (asset->font == nullptr) {
+                        std::cout << "Failed to load font " << asset->path << "! SDL_ttf Error: " << TTF_GetError() << std::endl;
+                    }
+                    asset->state.store(asset->font != nullptr ? AssetState::Ready : AssetState::Failed,
+                                       std::memory_order_release);
+                    break;
+                }
+            }
+            ++finished;
+            --inFlight;
+        }
+
+        if (i < draining.size()) {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            completions.insert(completions.begin(), draining.begin() + i, draining.end());
+        }
+        draining.clear();
+        return finished;
+    }
+
+    bool idle() const {
+        return inFlight.load() == 0;
+    }
+
+    int pendingCount() const {
+        return inFlight.load();
+    }
+
+    // Blocks until every request so far has finished, uploading as results
+    // arrive. For loading screens and shutdown, not for use mid-frame.
+    void finishAll() {
+        while (!idle()) {
+            if (processCompletions() == 0) SDL_Delay(1);
+        }
+    }
+
+    // Decoded sample memory; streamed sounds only hold the mixer's buffers.
+    size_t audioBytes() const {
+        size_t total = 0;
+        for (const auto& sound : sounds) {
+            Mix_Chunk* chunk = sound->chunk.load(std::memory_order_acquire);
+            if (chunk != nullptr) total += chunk->alen;
+        }
+        return total;
+    }
+};
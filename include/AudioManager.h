@@ -0,0 +1,217 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "AssetLoader.h"
+#include "RenderSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct AudioConfig {
+    int voiceCount = 16;
+    // Positional sounds play at full volume up to fullVolumeDistance from
+    // the camera centre and fade linearly to silence at silentDistance.
+    float fullVolumeDistance = 400.0f;
+    float silentDistance = 1600.0f;
+};
+
+struct SoundParams {
+    int priority = 0;
+    float volume = 1.0f;
+    bool positional = false;
+    float x = 0.0f;
+    float y = 0.0f;
+    // -1 loops forever, as in Mix_PlayChannel.
+    int loops = 0;
+};
+
+// Plays sounds from the AssetLoader through a fixed pool of mixer channels.
+// Decoded sounds share one chunk per path, so memory scales with distinct
+// sounds rather than with how many are playing; streamed sounds play on the
+// mixer's single music stream, which is one more voice. When every voice is
+// busy, a new sound takes the one with the lowest priority (the quietest,
+// then the oldest, among equals) if it ranks at least as high, and is
+// dropped otherwise. Playing never allocates, so a burst of events costs
+// only mixer calls. Main thread only.
+class AudioManager {
+public:
+    static constexpr int STREAM_VOICE = -2;
+
+private:
+    struct Voice {
+        const SoundAsset* sound = nullptr;
+        int priority = 0;
+        float volume = 1.0f;
+        float gain = 1.0f;
+        bool positional = false;
+        float x = 0.0f;
+        float y = 0.0f;
+        std::uint64_t startedAt = 0;
+    };
+
+    AudioConfig config;
+    std::vector<Voice> voices;
+    Voice streamVoice;
+    float listenerX = 0.0f;
+    float listenerY = 0.0f;
+    std::uint64_t playCount = 0;
+    std::uint64_t stolen = 0;
+    std::uint64_t dropped = 0;
+
+    float attenuation(bool positional, float x, float y) const {
+        if (!positional) return 1.0f;
+        float distance = std::sqrt((x - listenerX) * (x - listenerX) + (y - listenerY) * (y - listenerY));
+        if (distance <= config.fullVolumeDistance) return 1.0f;
+        if (distance >= config.silentDistance) return 0.0f;
+        return 1.0f - (distance - config.fullVolumeDistance) / (config.silentDistance - config.fullVolumeDistance);
+    }
+
+    static int mixerVolume(const Voice& voice) {
+        return (int)(voice.volume * voice.gain * MIX_MAX_VOLUME + 0.5f);
+    }
+
+    // Whether the playing voice current gives way to a new sound.
+    static bool yieldsTo(const Voice& current, int priority, float audibility) {
+        if (current.priority != priority) return current.priority < priority;
+        return current.volume * current.gain <= audibility;
+    }
+
+    static bool ranksBelow(const Voice& a, const Voice& b) {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        if (a.volume * a.gain != b.volume * b.gain) return a.volume * a.gain < b.volume * b.gain;
+        return a.startedAt < b.startedAt;
+    }
+
+    bool streamPlaying() const {
+        return streamVoice.sound != nullptr && Mix_PlayingMusic() != 0;
+    }
+
+    int playStream(const SoundAsset* sound, Mix_Music* stream, const SoundParams& params, float gain) {
+        if (streamPlaying() && !yieldsTo(streamVoice, params.priority, params.volume * gain)) {
+            ++dropped;
+            return -1;
+        }
+        if (streamPlaying()) ++stolen;
+
+        streamVoice = Voice{sound, params.priority, params.volume, gain, params.positional, params.x, params.y, ++playCount};
+        Mix_VolumeMusic(mixerVolume(streamVoice));
+        if (Mix_PlayMusic(stream, params.loops) < 0) {
+            streamVoice.sound = nullptr;
+            ++dropped;
+            return -1;
+        }
+        return STREAM_VOICE;
+    }
+
+public:
+    explicit AudioManager(AudioConfig config = AudioConfig()) : config(config), voices(std::max(1, config.voiceCount)) {
+        Mix_AllocateChannels((int)voices.size());
+    }
+
+    AudioManager(const AudioManager&) = delete;
+    AudioManager& operator=(const AudioManager&) = delete;
+
+    // Positional sounds are attenuated by their distance from the centre of
+    // the camera's view. Playing voices are re-attenuated as it moves.
+    void setListener(const Camera& camera) {
+        listenerX = camera.x + camera.width * 0.5f;
+        listenerY = camera.y + camera.height * 0.5f;
+
+        for (int channel = 0; channel < (int)voices.size(); ++channel) {
+            Voice& voice = voices[channel];
+            if (voice.sound == nullptr || !voice.positional) continue;
+            float gain = attenuation(true, voice.x, voice.y);
+            if (gain == voice.gain) continue;
+            voice.gain = gain;
+            Mix_Volume(channel, mixerVolume(voice));
+        }
+        if (streamVoice.sound != nullptr && streamVoice.positional) {
+            streamVoice.gain = attenuation(true, streamVoice.x, streamVoice.y);
+            Mix_VolumeMusic(mixerVolume(streamVoice));
+        }
+    }
+
+    // Returns the voice it plays on, or -1 if the sound is not loaded yet,
+    // is out of earshot, or lost to the voices already playing.
+    int play(const SoundAsset* sound, const SoundParams& params = SoundParams()) {
+        Mix_Chunk* chunk = sound->chunk.load(std::memory_order_acquire);
+        Mix_Music* stream = sound->stream.load(std::memory_order_acquire);
+        float gain = attenuation(params.positional, params.x, params.y);
+        if ((chunk == nullptr && stream == nullptr) || (gain <= 0.0f && params.loops == 0)) {
+            ++dropped;
+            return -1;
+        }
+        if (stream != nullptr) return playStream(sound, stream, params, gain);
+
+        int target = -1;
+        for (int channel = 0; channel < (int)voices.size(); ++channel) {
+            if (voices[channel].sound == nullptr || Mix_Playing(channel) == 0) {
+                target = channel;
+                break;
+            }
+        }
+        if (target < 0) {
+            target = 0;
+            for (int channel = 1; channel < (int)voices.size(); ++channel) {
+                if (ranksBelow(voices[channel], voices[target])) target = channel;
+            }
+            if (!yieldsTo(voices[target], params.priority, params.volume * gain)) {
+                ++dropped;
+                return -1;
+            }
+            Mix_HaltChannel(target);
+            ++stolen;
+        }
+
+        Voice& voice = voices[target];
+        voice = Voice{sound, params.priority, params.volume, gain, params.positional, params.x, params.y, ++playCount};
+        Mix_Volume(target, mixerVolume(voice));
+        if (Mix_PlayChannel(target, chunk, params.loops) < 0) {
+            voice.sound = nullptr;
+            ++dropped;
+            return -1;
+        }
+        return target;
+    }
+
+    void stop(int voice) {
+        if (voice == STREAM_VOICE) {
+            Mix_HaltMusic();
+            streamVoice.sound = nullptr;
+        } else if (voice >= 0 && voice < (int)voices.size()) {
+            Mix_HaltChannel(voice);
+            voices[voice].sound = nullptr;
+        }
+    }
+
+    // Must run before the AssetLoader frees the sounds.
+    void stopAll() {
+        Mix_HaltChannel(-1);
+        Mix_HaltMusic();
+        for (Voice& voice : voices) {
+            voice.sound = nullptr;
+        }
+        streamVoice.sound = nullptr;
+    }
+
+    int voiceCount() const {
+        return (int)voices.size();
+    }
+
+    int activeVoices() const {
+        int active = streamPlaying() ? 1 : 0;
+        for (int channel = 0; channel < (int)voices.size(); ++channel) {
+            if (voices[channel].sound != nullptr && Mix_Playing(channel) != 0) ++active;
+        }
+        return active;
+    }
+
+    std::uint64_t stolenCount() const {
+        return stolen;
+    }
+
+    std::uint64_t droppedCount() const {
+        return dropped;
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
+#include "ECS.h"
+#include "TextureAsset.h"
 
 struct Transform {
     float x;
@@ -10,6 +13,25 @@ struct Transform {
     float scaleY;
 };
 
+// Attachment to another entity; see TransformHierarchy. LocalTransform is the
+// offset from the parent, in the parent's rotated and scaled space.
+struct Parent {
+    Entity entity;
+};
+
+struct LocalTransform {
+    float x;
+    float y;
+    float rotation;
+    float scaleX;
+    float scaleY;
+};
+
+struct PreviousTransform {
+    float x;
+    float y;
+};
+
 struct Sprite {
     void* texture;
     int width;
@@ -18,8 +40,15 @@ struct Sprite {
     int srcY;
     int srcWidth;
     int srcHeight;
+    // When set, the texture comes from here instead and may still be the
+    // loader's placeholder.
+    const TextureAsset* asset = nullptr;
 };
 
+void* resolveSpriteTexture(const Sprite& sprite) {
+    return sprite.asset != nullptr ? sprite.asset->texture.load(std::memory_order_acquire) : sprite.texture;
+}
+
 struct Velocity {
     float vx;
     float vy;
@@ -46,16 +75,14 @@ struct PlayerController {
     bool isGrounded;
 };
 
+using AnimationClipHandle = std::uint32_t;
+
 struct Animation {
-    void* spriteSheet;
-    int frameWidth;
-    int frameHeight;
-    int totalFrames;
+    AnimationClipHandle clip;
     int currentFrame;
-    float frameTime;
     float elapsedTime;
-    bool loop;
     bool playing;
+    int appliedFrame = -1;
 };
 
 struct ParticleEmitter {
@@ -72,7 +99,7 @@ struct ParticleEmitter {
 
 struct Particle {
     float lifetime;
-    float age;
+    float spawnTime;
     int colorR;
     int colorG;
     int colorB;
@@ -86,5 +113,39 @@ struct Health {
 
 struct Lifetime {
     float duration;
-    float elapsed;
-};
\ No newline at end of file
+    float spawnTime;
+};
+
+// Set by WorldStreamer on entities instantiated from a region chunk.
+struct StreamedRegion {
+    std::int32_t x;
+    std::int32_t y;
+};
+
+// Integrated only on steps where countdown is 0, with the time of interval
+// steps at once. WorldStreamer puts it on regions just outside the view.
+struct ReducedRate {
+    std::uint8_t interval;
+    std::uint8_t countdown;
+};
+
+float reducedRateStep(const ReducedRate& rate, float deltaTime) {
+    return rate.countdown == 0 ? deltaTime * rate.interval : 0.0f;
+}
+
+// Steered along a FlowField by flowFieldSteeringSystem, which owns its
+// Velocity. The agent's centre is radius in from its Transform on both axes.
+struct NavAgent {
+    float speed;
+    float radius;
+};
+
+const int RENDER_LAYER_WORLD = 10;
+const int RENDER_LAYER_PARTICLES = 20;
+const int RENDER_LAYER_SPRITES = 30;
+const int RENDER_LAYER_DEBUG = 40;
+
+struct RenderLayer {
+    int layer;
+    float depth;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include "RenderSnapshot.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+enum class DrawKind : std::uint8_t {
+    Body,
+    Particle,
+    Sprite,
+    ColliderOutline
+};
+
+struct DrawCommand {
+    std::uint64_t key;
+    DrawKind kind;
+    std::uint32_t index;
+};
+
+// Maps a float onto a uint32 whose unsigned order matches the float order.
+std::uint32_t orderedFloatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Key layout, most significant first:
+//   layer (8) | depth (16) | texture (12) | material (4) | entity (24)
+// Ties are broken by entity ID so the order does not depend on pool order and
+// stays stable from frame to frame. Texture IDs past 4095 share bits, which
+// only costs batching, not determinism.
+static_assert(MAX_ENTITIES <= (1u << 24), "draw keys hold 24-bit entity IDs");
+
+std::uint64_t makeDrawKey(int layer, float depth, std::uint16_t textureId,
+                          DrawKind material, Entity entity) {
+    return ((std::uint64_t)(layer & 0xFF) << 56) |
+           ((std::uint64_t)(orderedFloatBits(depth) >> 16) << 40) |
+           ((std::uint64_t)(textureId & 0xFFF) << 28) |
+           ((std::uint64_t)((std::uint8_t)material & 0xF) << 24) |
+           (std::uint64_t)(entity & 0xFFFFFF);
+}
+
+// LSD radix sort on 8-bit digits. All digit histograms are gathered in one
+// pass and digits every key shares are skipped, so typical frames only pay for
+// the handful of bytes that actually vary. scratch only grows, never shrinks.
+void radixSortDrawCommands(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& scratch) {
+    const size_t count = commands.size();
+    if (count < 2) return;
+
+    if (scratch.size() < count) {
+        scratch.resize(count);
+    }
+
+    std::array<std::array<std::uint32_t, 256>, 8> histograms{};
+    for (const DrawCommand& command : commands) {
+        for (int digit = 0; digit < 8; ++digit) {
+            ++histograms[digit][(command.key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    DrawCommand* source = commands.data();
+    DrawCommand* destination = scratch.data();
+
+    for (int digit = 0; digit < 8; ++digit) {
+        auto& histogram = histograms[digit];
+        std::uint32_t firstBucket = (std::uint32_t)((source[0].key >> (digit * 8)) & 0xFF);
+        if (histogram[firstBucket] == count) continue;
+
+        std::uint32_t offset = 0;
+        for (std::uint32_t& bucket : histogram) {
+            std::uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            std::uint32_t bucket = (std::uint32_t)((source[i].key >> (digit * 8)) & 0xFF);
+            destination[histogram[bucket]++] = source[i];
+        }
+
+        std::swap(source, destination);
+    }
+
+    if (source != commands.data()) {
+        std::memcpy(commands.data(), source, count * sizeof(DrawCommand));
+    }
+}
+
+// Builds one sort-keyed command per draw in a snapshot. Vectors are reused
+// across frames, so after warm-up building and sorting do not allocate.
+class DrawQueue {
+private:
+    std::vector<DrawCommand> commands;
+    std::vector<DrawCommand> scratch;
+    std::unordered_map<void*, std::uint16_t> textureIds;
+
+    std::uint16_t textureId(void* texture) {
+        auto it = textureIds.find(texture);
+        if (it != textureIds.end()) {
+            return it->second;
+        }
+        std::uint16_t id = (std::uint16_t)(textureIds.size() + 1);
+        textureIds[texture] = id;
+        return id;
+    }
+
+public:
+    void build(const RenderSnapshot& snapshot, bool includeColliders) {
+        commands.clear();
+
+        for (std::uint32_t i = 0; i < snapshot.bodies.size(); ++i) {
+            const RectDraw& body = snapshot.bodies[i];
+            commands.push_back(DrawCommand{
+                makeDrawKey(RENDER_LAYER_WORLD, 0.0f, 0, DrawKind::Body, body.entity),
+                DrawKind::Body,
+                i
+            });
+        }
+
+        for (std::uint32_t i = 0; i < snapshot.particles.size(); ++i) {
+            const ParticleDraw& particle = snapshot.particles[i];
+            commands.push_back(DrawCommand{
+                makeDrawKey(RENDER_LAYER_PARTICLES, 0.0f, 0, DrawKind::Particle, particle.entity),
+                DrawKind::Particle,
+                i
+            });
+        }
+
+        for (std::uint32_t i = 0; i < snapshot.sprites.size(); ++i) {
+            const SpriteDraw& sprite = snapshot.sprites[i];
+            commands.push_back(DrawCommand{
+                makeDrawKey(sprite.layer, sprite.depth, textureId(sprite.texture), DrawKind::Sprite, sprite.entity),
+                DrawKind::Sprite,
+                i
+            });
+        }
+
+        if (includeColliders) {
+            for (std::uint32_t i = 0; i < snapshot.colliders.size(); ++i) {
+                const RectDraw& collider = snapshot.colliders[i];
+                commands.push_back(DrawCommand{
+                    makeDrawKey(RENDER_LAYER_DEBUG, 0.0f, 0, DrawKind::ColliderOutline, collider.entity),
+                    DrawKind::ColliderOutline,
+                    i
+                });
+            }
+        }
+
+        radixSortDrawCommands(commands, scratch);
+    }
+
+    const std::vector<DrawCommand>& sorted() const {
+        return commands;
+    }
+};
@@ -4,97 +4,293 @@
 #include <memory>
 #include <typeindex>
 #include <any>
-#include <array>
 #include <cstdint>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include "FrameArena.h"
 
 using Entity = std::uint32_t;
-const Entity MAX_ENTITIES = 5000;
+
+#ifndef GAME_ENGINE_MAX_ENTITIES
+#define GAME_ENGINE_MAX_ENTITIES 5000
+#endif
+const Entity MAX_ENTITIES = GAME_ENGINE_MAX_ENTITIES;
+const Entity INVALID_ENTITY = 0xFFFFFFFFu;
+
+struct ComponentPoolStats {
+    std::string name;
+    size_t componentSize;
+    size_t capacity;
+    size_t count;
+    size_t reservedBytes;
+    size_t usedBytes;
+    size_t indexBytes;
+};
+
+// Readable name for a component type: GCC/Clang mangle it as "<length><name>",
+// MSVC as "struct <name>".
+template<typename T>
+std::string componentTypeName() {
+    std::string name = typeid(T).name();
+    for (const char* prefix : {"struct ", "class "}) {
+        if (name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0) {
+            return name.substr(std::char_traits<char>::length(prefix));
+        }
+    }
+    size_t start = name.find_first_not_of("0123456789");
+    return start == std::string::npos ? name : name.substr(start);
+}
+
+class ComponentArray;
+
+// One pool's packed contents. create rebuilds an empty pool of the same type,
+// so a snapshot can be restored into an ECS that never registered it.
+struct PoolSnapshot {
+    std::type_index type = std::type_index(typeid(void));
+    std::shared_ptr<ComponentArray> (*create)(Entity capacity) = nullptr;
+    std::uint32_t count = 0;
+    std::vector<std::uint8_t> components;
+    std::vector<Entity> entities;
+};
+
+// Whole-world copy: every pool plus the entity allocator. Pools are sorted by
+// type so two snapshots of the same world line up index for index. Reusing a
+// WorldSnapshot across captures reuses its buffers.
+struct WorldSnapshot {
+    std::vector<PoolSnapshot> pools;
+    std::vector<Entity> recycledEntities;
+    std::vector<std::uint8_t> alive;
+    Entity nextFreshEntity = 0;
+    std::uint32_t livingCount = 0;
+
+    size_t byteSize() const {
+        size_t total = recycledEntities.size() * sizeof(Entity) + alive.size();
+        for (const PoolSnapshot& pool : pools) {
+            total += pool.components.size() + pool.entities.size() * sizeof(Entity);
+        }
+        return total;
+    }
+
+    // Heap held by the buffers, including spare capacity.
+    size_t reservedBytes() const {
+        size_t total = pools.capacity() * sizeof(PoolSnapshot) + recycledEntities.capacity() * sizeof(Entity) +
+                       alive.capacity();
+        for (const PoolSnapshot& pool : pools) {
+            total += pool.components.capacity() + pool.entities.capacity() * sizeof(Entity);
+        }
+        return total;
+    }
+};
 
 class ComponentArray {
 public:
     virtual ~ComponentArray() = default;
     virtual void entityDestroyed(Entity entity) = 0;
+    virtual ComponentPoolStats memoryStats() const = 0;
+    virtual void saveSnapshot(PoolSnapshot& snapshot) const = 0;
+    virtual void restoreSnapshot(const PoolSnapshot& snapshot) = 0;
+    virtual void clear() = 0;
 };
 
+// Packed component storage. The entity <-> index tables are flat arrays
+// rather than hash maps, so adding and removing components never allocates.
+// Everything is sized to the world's entity capacity once, on creation, and
+// never moves afterwards.
 template<typename T>
 class ComponentArrayImpl : public ComponentArray {
 private:
-    std::array<T, MAX_ENTITIES> componentArray;
-    std::unordered_map<Entity, size_t> entityToIndexMap;
-    std::unordered_map<size_t, Entity> indexToEntityMap;
+    static constexpr std::uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    std::vector<T> componentArray;
+    std::vector<std::uint32_t> entityToIndex;
+    std::vector<Entity> indexToEntity;
     size_t size = 0;
 
 public:
+    explicit ComponentArrayImpl(Entity capacity = MAX_ENTITIES)
+        : componentArray(capacity), entityToIndex(capacity, INVALID_INDEX), indexToEntity(capacity) {}
+
     void insertData(Entity entity, T component) {
-        if (entityToIndexMap.find(entity) != entityToIndexMap.end()) {
+        if (entityToIndex[entity] != INVALID_INDEX) {
             return;
         }
 
         size_t newIndex = size;
-        entityToIndexMap[entity] = newIndex;
-        indexToEntityMap[newIndex] = entity;
+        entityToIndex[entity] = (std::uint32_t)newIndex;
+        indexToEntity[newIndex] = entity;
         componentArray[newIndex] = component;
         ++size;
     }
 
     void removeData(Entity entity) {
-        if (entityToIndexMap.find(entity) == entityToIndexMap.end()) {
+        if (entityToIndex[entity] == INVALID_INDEX) {
             return;
         }
 
-        size_t indexOfRemovedEntity = entityToIndexMap[entity];
+        size_t indexOfRemovedEntity = entityToIndex[entity];
         size_t indexOfLastElement = size - 1;
         componentArray[indexOfRemovedEntity] = componentArray[indexOfLastElement];
 
-        Entity entityOfLastElement = indexToEntityMap[indexOfLastElement];
-        entityToIndexMap[entityOfLastElement] = indexOfRemovedEntity;
-        indexToEntityMap[indexOfRemovedEntity] = entityOfLastElement;
+        Entity entityOfLastElement = indexToEntity[indexOfLastElement];
+        entityToIndex[entityOfLastElement] = (std::uint32_t)indexOfRemovedEntity;
+        indexToEntity[indexOfRemovedEntity] = entityOfLastElement;
 
-        entityToIndexMap.erase(entity);
-        indexToEntityMap.erase(indexOfLastElement);
+        entityToIndex[entity] = INVALID_INDEX;
 
         --size;
     }
 
     T& getData(Entity entity) {
-        return componentArray[entityToIndexMap[entity]];
+        return componentArray[entityToIndex[entity]];
     }
 
     bool hasData(Entity entity) {
-        return entityToIndexMap.find(entity) != entityToIndexMap.end();
+        return entityToIndex[entity] != INVALID_INDEX;
     }
 
     void entityDestroyed(Entity entity) override {
-        if (entityToIndexMap.find(entity) != entityToIndexMap.end()) {
+        if (entityToIndex[entity] != INVALID_INDEX) {
             removeData(entity);
         }
     }
 
     std::vector<Entity> getEntities() {
-        std::vector<Entity> entities;
-        for (const auto& pair : entityToIndexMap) {
-            entities.push_back(pair.first);
-        }
+        return std::vector<Entity>(indexToEntity.begin(), indexToEntity.begin() + size);
+    }
+
+    FrameVector<Entity> getEntities(FrameArena& arena) {
+        FrameVector<Entity> entities = makeFrameVector<Entity>(arena, size);
+        entities.assign(indexToEntity.begin(), indexToEntity.begin() + size);
         return entities;
     }
+
+    size_t count() const {
+        return size;
+    }
+
+    // Packed storage in index order: components()[i] belongs to entities()[i].
+    const T* components() const {
+        return componentArray.data();
+    }
+
+    T* components() {
+        return componentArray.data();
+    }
+
+    const Entity* entities() const {
+        return indexToEntity.data();
+    }
+
+    // Appends count copies of value for entities that do not have this
+    // component yet, as one contiguous run at the end of the packed array.
+    // Returns the start of that run.
+    T* appendFilled(const Entity* entities, size_t count, const T& value) {
+        T* run = componentArray.data() + size;
+        std::fill_n(run, count, value);
+        std::memcpy(indexToEntity.data() + size, entities, count * sizeof(Entity));
+        for (size_t i = 0; i < count; ++i) {
+            entityToIndex[entities[i]] = (std::uint32_t)(size + i);
+        }
+        size += count;
+        return run;
+    }
+
+    // Replaces the whole pool with count packed components in two memcpys;
+    // only the entity -> index table is rebuilt element by element.
+    void assignPacked(const T* components, const Entity* entities, size_t count) {
+        clear();
+
+        if (count > 0) {
+            std::memcpy(componentArray.data(), components, count * sizeof(T));
+            std::memcpy(indexToEntity.data(), entities, count * sizeof(Entity));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            entityToIndex[entities[i]] = (std::uint32_t)i;
+        }
+        size = count;
+    }
+
+    static std::shared_ptr<ComponentArray> create(Entity capacity) {
+        return std::make_shared<ComponentArrayImpl<T>>(capacity);
+    }
+
+    void saveSnapshot(PoolSnapshot& snapshot) const override {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots copy components as raw bytes");
+        snapshot.type = std::type_index(typeid(T));
+        snapshot.create = &ComponentArrayImpl<T>::create;
+        snapshot.count = (std::uint32_t)size;
+        snapshot.components.resize(size * sizeof(T));
+        if (size > 0) {
+            std::memcpy(snapshot.components.data(), componentArray.data(), size * sizeof(T));
+        }
+        snapshot.entities.assign(indexToEntity.begin(), indexToEntity.begin() + size);
+    }
+
+    void restoreSnapshot(const PoolSnapshot& snapshot) override {
+        assignPacked((const T*)snapshot.components.data(), snapshot.entities.data(), snapshot.count);
+    }
+
+    void clear() override {
+        for (size_t i = 0; i < size; ++i) {
+            entityToIndex[indexToEntity[i]] = INVALID_INDEX;
+        }
+        size = 0;
+    }
+
+    ComponentPoolStats memoryStats() const override {
+        return ComponentPoolStats{
+            componentTypeName<T>(),
+            sizeof(T),
+            componentArray.size(),
+            size,
+            componentArray.size() * sizeof(T),
+            size * sizeof(T),
+            entityToIndex.size() * sizeof(std::uint32_t) + indexToEntity.size() * sizeof(Entity)
+        };
+    }
 };
 
 class ComponentManager {
 private:
     std::unordered_map<std::type_index, std::shared_ptr<ComponentArray>> componentArrays;
+    // The same pools in type order, kept sorted as they are registered, so
+    // snapshots list them in a fixed order without sorting.
+    std::vector<std::pair<std::type_index, ComponentArray*>> sortedArrays;
+    Entity capacity;
+
+    void registerArray(std::type_index type, std::shared_ptr<ComponentArray> array) {
+        auto position = std::lower_bound(sortedArrays.begin(), sortedArrays.end(), type,
+            [](const std::pair<std::type_index, ComponentArray*>& entry, std::type_index key) { return entry.first < key; });
+        sortedArrays.insert(position, std::make_pair(type, array.get()));
+        componentArrays[type] = std::move(array);
+    }
 
     template<typename T>
     std::shared_ptr<ComponentArrayImpl<T>> getComponentArray() {
         std::type_index typeIndex(typeid(T));
 
         if (componentArrays.find(typeIndex) == componentArrays.end()) {
-            componentArrays[typeIndex] = std::make_shared<ComponentArrayImpl<T>>();
+            registerArray(typeIndex, std::make_shared<ComponentArrayImpl<T>>(capacity));
         }
 
         return std::static_pointer_cast<ComponentArrayImpl<T>>(componentArrays[typeIndex]);
     }
 
 public:
+    explicit ComponentManager(Entity capacity = MAX_ENTITIES) : capacity(capacity) {}
+
+    template<typename T>
+    ComponentArrayImpl<T>& pool() {
+        return *getComponentArray<T>();
+    }
+
+    template<typename T>
+    bool hasPool() const {
+        return componentArrays.find(std::type_index(typeid(T))) != componentArrays.end();
+    }
+
     template<typename T>
     void addComponent(Entity entity, T component) {
         getComponentArray<T>()->insertData(entity, component);
@@ -126,49 +322,185 @@ public:
     std::vector<Entity> getEntitiesWithComponent() {
         return getComponentArray<T>()->getEntities();
     }
+
+    template<typename T>
+    FrameVector<Entity> getEntitiesWithComponent(FrameArena& arena) {
+        return getComponentArray<T>()->getEntities(arena);
+    }
+
+    // Each pool keeps its slot from one capture to the next, so a reused
+    // vector reuses every pool's buffers. A pool registered since the last
+    // capture gets a new slot rather than shifting the others' buffers.
+    void snapshot(std::vector<PoolSnapshot>& pools) const {
+        for (size_t i = 0; i < sortedArrays.size(); ++i) {
+            if (i == pools.size() || (pools[i].type != sortedArrays[i].first && pools.size() < sortedArrays.size())) {
+                pools.insert(pools.begin() + i, PoolSnapshot());
+            }
+            sortedArrays[i].second->saveSnapshot(pools[i]);
+        }
+        pools.resize(sortedArrays.size());
+    }
+
+    // Pools the snapshot does not mention were registered after it was taken
+    // and are emptied.
+    void restore(const std::vector<PoolSnapshot>& pools) {
+        for (auto const& pair : componentArrays) {
+            pair.second->clear();
+        }
+        for (const PoolSnapshot& pool : pools) {
+            if (componentArrays.find(pool.type) == componentArrays.end()) {
+                registerArray(pool.type, pool.create(capacity));
+            }
+            componentArrays[pool.type]->restoreSnapshot(pool);
+        }
+    }
+
+    void collectPoolStats(std::vector<ComponentPoolStats>& pools) const {
+        for (auto const& pair : componentArrays) {
+            pools.push_back(pair.second->memoryStats());
+        }
+    }
+
+    // Approximate: one pointer per bucket plus, per pool, the map node and
+    // the shared_ptr control block that make_shared places beside the pool,
+    // and the type-ordered index.
+    size_t registryBytes() const {
+        return componentArrays.bucket_count() * sizeof(void*) +
+               componentArrays.size() * (sizeof(std::pair<const std::type_index, std::shared_ptr<ComponentArray>>) +
+                                         sizeof(void*) + 2 * sizeof(long)) +
+               sortedArrays.capacity() * sizeof(std::pair<std::type_index, ComponentArray*>);
+    }
 };
 
+// IDs that have never been handed out are implicit: everything from
+// nextFreshEntity up is free, so the manager's state (and a snapshot of it)
+// only grows with the IDs actually used. Destroyed IDs are reused first,
+// most recently destroyed first, then fresh IDs in ascending order.
 class EntityManager {
 private:
-    std::vector<Entity> availableEntities;
+    std::vector<Entity> recycledEntities;
+    std::vector<std::uint8_t> alive;
+    Entity nextFreshEntity = 0;
     uint32_t livingEntityCount = 0;
 
 public:
-    EntityManager() {
-        for (Entity entity = MAX_ENTITIES - 1; entity >= 0; --entity) {
-            availableEntities.push_back(entity);
-            if (entity == 0) break;
-        }
-    }
+    explicit EntityManager(Entity capacity = MAX_ENTITIES) : alive(capacity, 0) {}
 
     Entity createEntity() {
-        Entity id = availableEntities.back();
-        availableEntities.pop_back();
+        Entity id;
+        if (!recycledEntities.empty()) {
+            id = recycledEntities.back();
+            recycledEntities.pop_back();
+        } else {
+            id = nextFreshEntity++;
+        }
+        alive[id] = 1;
         ++livingEntityCount;
         return id;
     }
 
+    // Same IDs, in the same order, as count calls to createEntity.
+    void createEntities(Entity* out, size_t count) {
+        size_t recycled = std::min(count, recycledEntities.size());
+        for (size_t i = 0; i < recycled; ++i) {
+            out[i] = recycledEntities[recycledEntities.size() - 1 - i];
+        }
+        recycledEntities.resize(recycledEntities.size() - recycled);
+        for (size_t i = recycled; i < count; ++i) {
+            out[i] = nextFreshEntity++;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            alive[out[i]] = 1;
+        }
+        livingEntityCount += (uint32_t)count;
+    }
+
     void destroyEntity(Entity entity) {
-        availableEntities.push_back(entity);
+        recycledEntities.push_back(entity);
+        alive[entity] = 0;
         --livingEntityCount;
     }
+
+    bool isAlive(Entity entity) const {
+        return alive[entity] != 0;
+    }
+
+    // IDs are always below this.
+    Entity capacity() const {
+        return (Entity)alive.size();
+    }
+
+    // One past the highest ID ever handed out.
+    Entity entityCapacityUsed() const {
+        return nextFreshEntity;
+    }
+
+    // Makes exactly the given entities alive. The gaps below the highest one
+    // become recycled IDs, handed out lowest first.
+    void assignLiving(const Entity* living, size_t count) {
+        std::fill(alive.begin(), alive.begin() + nextFreshEntity, 0);
+        nextFreshEntity = 0;
+        for (size_t i = 0; i < count; ++i) {
+            alive[living[i]] = 1;
+            nextFreshEntity = std::max(nextFreshEntity, living[i] + 1);
+        }
+
+        recycledEntities.clear();
+        for (Entity entity = nextFreshEntity; entity-- > 0;) {
+            if (!alive[entity]) recycledEntities.push_back(entity);
+        }
+        livingEntityCount = (uint32_t)count;
+    }
+
+    void snapshot(WorldSnapshot& snapshot) const {
+        snapshot.recycledEntities.assign(recycledEntities.begin(), recycledEntities.end());
+        snapshot.alive.assign(alive.begin(), alive.begin() + nextFreshEntity);
+        snapshot.nextFreshEntity = nextFreshEntity;
+        snapshot.livingCount = livingEntityCount;
+    }
+
+    void restore(const WorldSnapshot& snapshot) {
+        if (snapshot.nextFreshEntity < nextFreshEntity) {
+            std::fill(alive.begin() + snapshot.nextFreshEntity, alive.begin() + nextFreshEntity, 0);
+        }
+        std::copy(snapshot.alive.begin(), snapshot.alive.end(), alive.begin());
+        recycledEntities.assign(snapshot.recycledEntities.begin(), snapshot.recycledEntities.end());
+        nextFreshEntity = snapshot.nextFreshEntity;
+        livingEntityCount = snapshot.livingCount;
+    }
+
+    uint32_t livingCount() const {
+        return livingEntityCount;
+    }
+
+    size_t reservedBytes() const {
+        return recycledEntities.capacity() * sizeof(Entity) + alive.capacity();
+    }
 };
 
+// One world. Its entity capacity bounds the IDs it hands out and sizes every
+// pool it creates, so a small world costs capacity slots per component type
+// rather than MAX_ENTITIES. Worlds share nothing and can be stepped on
+// different threads at the same time.
 class ECS {
 private:
     std::unique_ptr<ComponentManager> componentManager;
     std::unique_ptr<EntityManager> entityManager;
 
 public:
-    ECS() {
-        componentManager = std::make_unique<ComponentManager>();
-        entityManager = std::make_unique<EntityManager>();
+    explicit ECS(Entity capacity = MAX_ENTITIES) {
+        componentManager = std::make_unique<ComponentManager>(capacity);
+        entityManager = std::make_unique<EntityManager>(capacity);
     }
 
     Entity createEntity() {
         return entityManager->createEntity();
     }
 
+    void createEntities(Entity* out, size_t count) {
+        entityManager->createEntities(out, count);
+    }
+
     void destroyEntity(Entity entity) {
         entityManager->destroyEntity(entity);
         componentManager->entityDestroyed(entity);
@@ -198,4 +530,46 @@ public:
     std::vector<Entity> getEntitiesWithComponent() {
         return componentManager->getEntitiesWithComponent<T>();
     }
+
+    // Scratch list for systems: lives in the arena until its next reset.
+    template<typename T>
+    FrameVector<Entity> getEntitiesWithComponent(FrameArena& arena) {
+        return componentManager->getEntitiesWithComponent<T>(arena);
+    }
+
+    // Copies every pool and the entity allocator in bulk, reusing the
+    // snapshot's buffers.
+    void snapshot(WorldSnapshot& snapshot) const {
+        componentManager->snapshot(snapshot.pools);
+        entityManager->snapshot(snapshot);
+    }
+
+    WorldSnapshot snapshot() const {
+        WorldSnapshot result;
+        snapshot(result);
+        return result;
+    }
+
+    void restore(const WorldSnapshot& snapshot) {
+        componentManager->restore(snapshot.pools);
+        entityManager->restore(snapshot);
+    }
+
+    // Direct access to a pool's packed storage, for bulk load/save.
+    template<typename T>
+    ComponentArrayImpl<T>& pool() {
+        return componentManager->pool<T>();
+    }
+
+    EntityManager& entities() {
+        return *entityManager;
+    }
+
+    const ComponentManager& components() const {
+        return *componentManager;
+    }
+
+    const EntityManager& entities() const {
+        return *entityManager;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,171 @@
+#pragma once
+#include "ECS.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timer wheel keyed on absolute expiry tick. Each level has 256
+// slots; an entry lives on the lowest level whose slot range still shares its
+// tick's higher bits with the current tick, and is cascaded down a level when
+// the wheel reaches that range. Advancing costs O(ticks elapsed + entries
+// due), independent of how many entries are still pending.
+class ExpiryWheel {
+public:
+    struct Entry {
+        Entity entity;
+        std::uint64_t tick;
+    };
+
+private:
+    static constexpr double TICK_SECONDS = 1.0 / 240.0;
+    static constexpr int LEVELS = 3;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr std::uint64_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    // Entries live in one pool shared by every slot; a slot is a FIFO list
+    // threaded through it. Cascading relinks nodes instead of copying them,
+    // and firing returns them to the free list, so the wheel only allocates
+    // when more entries are pending than ever before. The pool starts with
+    // room for one entry per entity.
+    struct Node {
+        Entry entry;
+        std::uint32_t next;
+    };
+
+    struct Slot {
+        std::uint32_t head = NONE;
+        std::uint32_t tail = NONE;
+    };
+
+    std::array<std::array<Slot, 1u << SLOT_BITS>, LEVELS> levels;
+    Slot overflow;
+    std::vector<Node> nodes;
+    std::uint32_t freeNodes = NONE;
+    std::vector<Entry> due;
+    std::uint64_t currentTick = 0;
+    double now = 0.0;
+    size_t pending = 0;
+
+    void link(Slot& slot, std::uint32_t node) {
+        nodes[node].next = NONE;
+        if (slot.tail == NONE) {
+            slot.head = node;
+        } else {
+            nodes[slot.tail].next = node;
+        }
+        slot.tail = node;
+    }
+
+    void place(std::uint32_t node) {
+        std::uint64_t tick = nodes[node].entry.tick;
+        for (int level = 0; level < LEVELS; ++level) {
+            int higherShift = SLOT_BITS * (level + 1);
+            if ((tick >> higherShift) == (currentTick >> higherShift)) {
+                link(levels[level][(tick >> (SLOT_BITS * level)) & SLOT_MASK], node);
+                return;
+            }
+        }
+        link(overflow, node);
+    }
+
+    void cascade(Slot& slot) {
+        std::uint32_t node = slot.head;
+        slot = Slot();
+        while (node != NONE) {
+            std::uint32_t next = nodes[node].next;
+            place(node);
+            node = next;
+        }
+    }
+
+    void step() {
+        ++currentTick;
+
+        if ((currentTick & ((1ull << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+            cascade(overflow);
+        }
+        for (int level = LEVELS - 1; level >= 1; --level) {
+            int shift = SLOT_BITS * level;
+            if ((currentTick & ((1ull << shift) - 1)) == 0) {
+                cascade(levels[level][(currentTick >> shift) & SLOT_MASK]);
+            }
+        }
+
+        Slot& slot = levels[0][currentTick & SLOT_MASK];
+        std::uint32_t node = slot.head;
+        slot = Slot();
+        while (node != NONE) {
+            std::uint32_t next = nodes[node].next;
+            due.push_back(nodes[node].entry);
+            nodes[node].next = freeNodes;
+            freeNodes = node;
+            --pending;
+            node = next;
+        }
+    }
+
+public:
+    ExpiryWheel() {
+        nodes.reserve(MAX_ENTITIES);
+    }
+
+    std::uint64_t tickFor(double time) const {
+        return (std::uint64_t)std::ceil(time / TICK_SECONDS);
+    }
+
+    float time() const {
+        return (float)now;
+    }
+
+    size_t pendingCount() const {
+        return pending;
+    }
+
+    // Entries already past due fire on the next tick.
+    void schedule(Entity entity, double expiryTime) {
+        std::uint64_t tick = tickFor(expiryTime);
+        if (tick <= currentTick) {
+            tick = currentTick + 1;
+        }
+        std::uint32_t node = freeNodes;
+        if (node != NONE) {
+            freeNodes = nodes[node].next;
+            nodes[node].entry = Entry{entity, tick};
+        } else {
+            node = (std::uint32_t)nodes.size();
+            nodes.push_back(Node{Entry{entity, tick}, NONE});
+        }
+        place(node);
+        ++pending;
+    }
+
+    // Drops every pending entry and sets the clock, for when the world the
+    // wheel tracks has been rolled back. The entry pool keeps its capacity.
+    void reset(double time) {
+        for (auto& level : levels) {
+            level.fill(Slot());
+        }
+        overflow = Slot();
+        nodes.clear();
+        freeNodes = NONE;
+        due.clear();
+        pending = 0;
+        now = time;
+        currentTick = (std::uint64_t)std::floor(time / TICK_SECONDS);
+    }
+
+    // Moves the clock forward and returns every entry whose tick has come due.
+    // The returned buffer is reused by the next call.
+    const std::vector<Entry>& advance(float deltaTime) {
+        due.clear();
+        now += deltaTime;
+
+        std::uint64_t targetTick = (std::uint64_t)std::floor(now / TICK_SECONDS);
+        while (currentTick < targetTick) {
+            step();
+        }
+        return due;
+    }
+};
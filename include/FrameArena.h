@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Bump allocator for scratch memory that only lives until the end of the
+// current step or frame. Allocation is a pointer bump and freeing is a no-op;
+// reset() releases everything at once. If a frame outgrows the current block
+// an overflow block is chained on, and the next reset() folds the blocks into
+// one block sized for the high-water mark, so a steady workload stops calling
+// malloc after its first few frames.
+class FrameArena {
+private:
+    struct Block {
+        std::uint8_t* memory;
+        size_t capacity;
+    };
+
+    static constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    std::vector<Block> blocks;
+    size_t offset = 0;
+    size_t usedInFullBlocks = 0;
+    size_t highWater = 0;
+    std::uint64_t blockAllocations = 0;
+
+    void addBlock(size_t minimumSize) {
+        size_t capacity = std::max(minimumSize, MIN_BLOCK_SIZE);
+        if (!blocks.empty()) {
+            capacity = std::max(capacity, blocks.back().capacity * 2);
+        }
+        std::uint8_t* memory = (std::uint8_t*)std::malloc(capacity);
+        if (memory == nullptr) throw std::bad_alloc();
+        blocks.push_back(Block{memory, capacity});
+        ++blockAllocations;
+    }
+
+public:
+    explicit FrameArena(size_t initialSize = MIN_BLOCK_SIZE) {
+        blocks.reserve(16);
+        addBlock(initialSize);
+    }
+
+    ~FrameArena() {
+        for (Block& block : blocks) {
+            std::free(block.memory);
+        }
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment) {
+        Block& block = blocks.back();
+        std::uintptr_t base = (std::uintptr_t)block.memory;
+        size_t aligned = (size_t)(((base + offset + alignment - 1) & ~(std::uintptr_t)(alignment - 1)) - base);
+
+        if (aligned + size > block.capacity) {
+            usedInFullBlocks += offset;
+            addBlock(size + alignment);
+            offset = 0;
+            return allocate(size, alignment);
+        }
+
+        offset = aligned + size;
+        return block.memory + aligned;
+    }
+
+    void reset() {
+        highWater = std::max(highWater, bytesUsed());
+
+        if (blocks.size() > 1) {
+            for (Block& block : blocks) {
+                std::free(block.memory);
+            }
+            blocks.clear();
+            addBlock(highWater + highWater / 2);
+        }
+
+        offset = 0;
+        usedInFullBlocks = 0;
+    }
+
+    size_t bytesUsed() const {
+        return usedInFullBlocks + offset;
+    }
+
+    size_t bytesReserved() const {
+        size_t total = 0;
+        for (const Block& block : blocks) {
+            total += block.capacity;
+        }
+        return total;
+    }
+
+    size_t highWaterMark() const {
+        return std::max(highWater, bytesUsed());
+    }
+
+    // Number of times the arena has had to go to malloc for a block.
+    std::uint64_t blockAllocationCount() const {
+        return blockAllocations;
+    }
+};
+
+// Each thread gets its own arena, so systems on the simulation thread and the
+// render thread never contend. The owning loop resets it once per step/frame.
+FrameArena& frameArena() {
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+// STL allocator over a FrameArena. deallocate is a no-op: the memory comes
+// back when the arena is reset, so containers using it must not outlive the
+// step or frame they were created in.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    FrameArena* arena;
+
+    ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        return (T*)arena->allocate(count * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena != other.arena;
+    }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+template<typename T>
+FrameVector<T> makeFrameVector(FrameArena& arena, size_t reserve = 0) {
+    FrameVector<T> vector{ArenaAllocator<T>(arena)};
+    vector.reserve(reserve);
+    return vector;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <SDL.h>
+#include <algorithm>
+#include <array>
+#include <thread>
+
+// Sleeps in whole milliseconds until the deadline is close, then yields for
+// the remainder: SDL_Delay alone can overshoot by a full scheduler quantum.
+void preciseWaitUntil(Uint64 deadline, double spinSeconds = 0.002) {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 spinCounts = (Uint64)(spinSeconds * frequency);
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    while (now + spinCounts < deadline) {
+        Uint32 sleepMs = (Uint32)((deadline - spinCounts - now) * 1000 / frequency);
+        if (sleepMs == 0) break;
+        SDL_Delay(sleepMs);
+        now = SDL_GetPerformanceCounter();
+    }
+
+    while (SDL_GetPerformanceCounter() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+struct FrameStats {
+    float p50Ms;
+    float p95Ms;
+    float p99Ms;
+    float maxMs;
+    int missedInWindow;
+    int totalMissed;
+    int count;
+};
+
+// Frame times over the most recent WINDOW frames, kept both as a ring (for
+// the exact max) and as fixed-width buckets so percentiles are a bucket scan
+// rather than a sort.
+class FrameTimeHistogram {
+public:
+    static constexpr int WINDOW = 600;
+    static constexpr float BUCKET_MS = 0.25f;
+    static constexpr int BUCKETS = 256;
+
+private:
+    std::array<float, WINDOW> samples{};
+    std::array<bool, WINDOW> missedSamples{};
+    std::array<int, BUCKETS + 1> buckets{};
+    int next = 0;
+    int count = 0;
+    int missedInWindow = 0;
+    int totalMissed = 0;
+
+    static int bucketFor(float ms) {
+        int bucket = (int)(ms / BUCKET_MS);
+        return std::clamp(bucket, 0, BUCKETS);
+    }
+
+    float percentile(float fraction) const {
+        int rank = std::max(1, (int)(fraction * count + 0.5f));
+        int seen = 0;
+        for (int bucket = 0; bucket <= BUCKETS; ++bucket) {
+            seen += buckets[bucket];
+            if (seen >= rank) {
+                return (bucket + 1) * BUCKET_MS;
+            }
+        }
+        return BUCKETS * BUCKET_MS;
+    }
+
+public:
+    void record(float ms, bool missed) {
+        if (count == WINDOW) {
+            --buckets[bucketFor(samples[next])];
+            if (missedSamples[next]) --missedInWindow;
+        } else {
+            ++count;
+        }
+
+        samples[next] = ms;
+        missedSamples[next] = missed;
+        ++buckets[bucketFor(ms)];
+        if (missed) {
+            ++missedInWindow;
+            ++totalMissed;
+        }
+        next = (next + 1) % WINDOW;
+    }
+
+    FrameStats stats() const {
+        FrameStats result{0.0f, 0.0f, 0.0f, 0.0f, missedInWindow, totalMissed, count};
+        if (count == 0) return result;
+
+        result.p50Ms = percentile(0.50f);
+        result.p95Ms = percentile(0.95f);
+        result.p99Ms = percentile(0.99f);
+        for (int i = 0; i < count; ++i) {
+            result.maxMs = std::max(result.maxMs, samples[i]);
+        }
+        return result;
+    }
+};
+
+// Paces the render loop off SDL_GetPerformanceCounter. In vsync mode the
+// present call already blocks, so the pacer only measures.
+class FramePacer {
+private:
+    Uint64 frequency;
+    Uint64 period;
+    Uint64 nextDeadline;
+    Uint64 lastFrameStart = 0;
+    bool vsync;
+    FrameTimeHistogram histogram;
+
+public:
+    FramePacer(int targetFps, bool vsync)
+        : frequency(SDL_GetPerformanceFrequency()),
+          period(SDL_GetPerformanceFrequency() / targetFps),
+          nextDeadline(SDL_GetPerformanceCounter()),
+          vsync(vsync) {}
+
+    // Records the interval since the previous frame started; an interval more
+    // than half a period late counts as a missed frame.
+    void beginFrame() {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (lastFrameStart != 0) {
+            Uint64 interval = now - lastFrameStart;
+            float ms = (float)((double)interval * 1000.0 / frequency);
+            histogram.record(ms, interval * 2 > period * 3);
+        }
+        lastFrameStart = now;
+    }
+
+    void waitForNextFrame() {
+        nextDeadline += period;
+        if (!vsync) {
+            preciseWaitUntil(nextDeadline);
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now > nextDeadline) {
+            nextDeadline = now;
+        }
+    }
+
+    FrameStats stats() const {
+        return histogram.stats();
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include "ECS.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Where the process's memory sits, split the way instance sizing needs it:
+// component pools reserve the world's entity capacity up front whether used
+// or not, so reserved and used bytes are reported separately, alongside the
+// fixed index tables and the heap totals from AllocationCounter.
+struct MemoryStats {
+    std::vector<ComponentPoolStats> pools;
+    size_t maxEntities = MAX_ENTITIES;
+    size_t livingEntities = 0;
+
+    size_t poolReservedBytes = 0;
+    size_t poolUsedBytes = 0;
+    size_t indexBytes = 0;
+    size_t registryBytes = 0;
+    size_t entityManagerBytes = 0;
+
+    size_t simulationArenaReservedBytes = 0;
+    size_t simulationArenaHighWaterBytes = 0;
+    size_t renderArenaReservedBytes = 0;
+    size_t renderArenaHighWaterBytes = 0;
+
+    size_t textureBytes = 0;
+    size_t audioBytes = 0;
+
+    std::int64_t heapLiveBytes = 0;
+    std::int64_t heapPeakBytes = 0;
+    std::uint64_t heapAllocations = 0;
+    std::uint64_t simulationAllocationsPerPublish = 0;
+    std::uint64_t renderAllocationsPerFrame = 0;
+
+    // Fixed cost of one entity slot across every registered pool, paid
+    // whether or not the slot is alive.
+    double bytesPerEntitySlot() const {
+        return maxEntities > 0 ? (double)(poolReservedBytes + indexBytes) / maxEntities : 0.0;
+    }
+
+    // Component bytes actually in use per living entity.
+    double usedBytesPerLivingEntity() const {
+        return livingEntities > 0 ? (double)poolUsedBytes / livingEntities : 0.0;
+    }
+};
+
+// ECS figures must be collected on the thread that owns the ECS.
+void collectEcsMemoryStats(const ECS& ecs, MemoryStats& stats) {
+    stats.pools.clear();
+    ecs.components().collectPoolStats(stats.pools);
+    std::sort(stats.pools.begin(), stats.pools.end(),
+              [](const ComponentPoolStats& a, const ComponentPoolStats& b) { return a.name < b.name; });
+
+    stats.poolReservedBytes = 0;
+    stats.poolUsedBytes = 0;
+    stats.indexBytes = 0;
+    for (const ComponentPoolStats& pool : stats.pools) {
+        stats.poolReservedBytes += pool.reservedBytes;
+        stats.poolUsedBytes += pool.usedBytes;
+        stats.indexBytes += pool.indexBytes;
+    }
+
+    stats.registryBytes = ecs.components().registryBytes();
+    stats.entityManagerBytes = ecs.entities().reservedBytes();
+    stats.livingEntities = ecs.entities().livingCount();
+    stats.maxEntities = ecs.entities().capacity();
+}
+
+void collectHeapMemoryStats(MemoryStats& stats) {
+    HeapCounters& heap = heapCounters();
+    stats.heapLiveBytes = heap.liveBytes.load(std::memory_order_relaxed);
+    stats.heapPeakBytes = heap.peakBytes.load(std::memory_order_relaxed);
+    stats.heapAllocations = heap.allocations.load(std::memory_order_relaxed);
+}
+
+bool writeMemoryStatsJson(const MemoryStats& stats, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"max_entities\": %zu,\n", stats.maxEntities);
+    fprintf(file, "  \"living_entities\": %zu,\n", stats.livingEntities);
+    fprintf(file, "  \"bytes_per_entity_slot\": %.1f,\n", stats.bytesPerEntitySlot());
+    fprintf(file, "  \"used_bytes_per_living_entity\": %.1f,\n", stats.usedBytesPerLivingEntity());
+    fprintf(file, "  \"component_pools\": [\n");
+    for (size_t i = 0; i < stats.pools.size(); ++i) {
+        const ComponentPoolStats& pool = stats.pools[i];
+        fprintf(file, "    {\"name\": \"%s\", \"component_size\": %zu, \"capacity\": %zu, \"count\": %zu, "
+                      "\"reserved_bytes\": %zu, \"used_bytes\": %zu, \"index_bytes\": %zu}%s\n",
+                pool.name.c_str(), pool.componentSize, pool.capacity, pool.count,
+                pool.reservedBytes, pool.usedBytes, pool.indexBytes, i + 1 < stats.pools.size() ? "," : "");
+    }
+    fprintf(file, "  ],\n");
+    fprintf(file, "  \"pool_reserved_bytes\": %zu,\n", stats.poolReservedBytes);
+    fprintf(file, "  \"pool_used_bytes\": %zu,\n", stats.poolUsedBytes);
+    fprintf(file, "  \"index_bytes\": %zu,\n", stats.indexBytes);
+    fprintf(file, "  \"registry_bytes\": %zu,\n", stats.registryBytes);
+    fprintf(file, "  \"entity_manager_bytes\": %zu,\n", stats.entityManagerBytes);
+    fprintf(file, "  \"simulation_arena\": {\"reserved_bytes\": %zu, \"high_water_bytes\": %zu},\n",
+            stats.simulationArenaReservedBytes, stats.simulationArenaHighWaterBytes);
+    fprintf(file, "  \"render_arena\": {\"reserved_bytes\": %zu, \"high_water_bytes\": %zu},\n",
+            stats.renderArenaReservedBytes, stats.renderArenaHighWaterBytes);
+    fprintf(file, "  \"texture_bytes\": %zu,\n", stats.textureBytes);
+    fprintf(file, "  \"audio_bytes\": %zu,\n", stats.audioBytes);
+    fprintf(file, "  \"heap\": {\"live_bytes\": %lld, \"peak_bytes\": %lld, \"allocations\": %llu, "
+                  "\"simulation_allocations_per_publish\": %llu, \"render_allocations_per_frame\": %llu}\n",
+            (long long)stats.heapLiveBytes, (long long)stats.heapPeakBytes,
+            (unsigned long long)stats.heapAllocations,
+            (unsigned long long)stats.simulationAllocationsPerPublish,
+            (unsigned long long)stats.renderAllocationsPerFrame);
+    fprintf(file, "}\n");
+
+    return fclose(file) == 0;
+}
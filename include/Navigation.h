@@ -0,0 +1,435 @@
+#pragma once
+#include "ECS.h"
+#include "Components.h"
+#include "FrameArena.h"
+#include "PhysicsSystem.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Walkable cells of a uniform grid laid over the world. build() blocks every
+// cell that overlaps a static, solid collider grown by the clearance, so an
+// agent of that radius whose centre stays in open cells clears the collider.
+class NavGrid {
+private:
+    float size = 32.0f;
+    int columns = 0;
+    int rows = 0;
+    std::vector<std::uint8_t> blockedCells;
+    std::uint32_t changeCount = 0;
+
+public:
+    // Clears the grid to open cells covering worldWidth x worldHeight.
+    void reset(float worldWidth, float worldHeight, float cellSize) {
+        size = cellSize;
+        columns = std::max(1, (int)std::ceil(worldWidth / cellSize));
+        rows = std::max(1, (int)std::ceil(worldHeight / cellSize));
+        blockedCells.assign((size_t)columns * rows, 0);
+        ++changeCount;
+    }
+
+    // Blocks every cell overlapping [left, right) x [top, bottom).
+    void block(float left, float top, float right, float bottom) {
+        int x0 = std::max(0, (int)std::floor(left / size));
+        int y0 = std::max(0, (int)std::floor(top / size));
+        int x1 = std::min(columns - 1, (int)std::ceil(right / size) - 1);
+        int y1 = std::min(rows - 1, (int)std::ceil(bottom / size) - 1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                blockedCells[(size_t)y * columns + x] = 1;
+            }
+        }
+        ++changeCount;
+    }
+
+    void build(ECS& ecs, float worldWidth, float worldHeight, float cellSize, float clearance) {
+        reset(worldWidth, worldHeight, cellSize);
+
+        auto& transforms = ecs.pool<Transform>();
+        auto& rigidBodies = ecs.pool<RigidBody>();
+        auto& colliders = ecs.pool<Collider>();
+        const Entity* entities = colliders.entities();
+        for (size_t i = 0; i < colliders.count(); ++i) {
+            Entity entity = entities[i];
+            const Collider& collider = colliders.components()[i];
+            if (collider.isTrigger || !transforms.hasData(entity) || !rigidBodies.hasData(entity) ||
+                !rigidBodies.getData(entity).isStatic) {
+                continue;
+            }
+            AABB box = getAABB(transforms.getData(entity), collider);
+            block(box.x - clearance, box.y - clearance, box.x + box.width + clearance, box.y + box.height + clearance);
+        }
+    }
+
+    float cellSize() const {
+        return size;
+    }
+
+    int width() const {
+        return columns;
+    }
+
+    int height() const {
+        return rows;
+    }
+
+    bool blocked(int x, int y) const {
+        return blockedCells[(size_t)y * columns + x] != 0;
+    }
+
+    // The cell under a world position, clamped to the grid.
+    int cellAt(float x, float y) const {
+        int cellX = std::min(columns - 1, std::max(0, (int)std::floor(x / size)));
+        int cellY = std::min(rows - 1, std::max(0, (int)std::floor(y / size)));
+        return cellY * columns + cellX;
+    }
+
+    // Changes whenever a cell does, so fields know when to rebuild.
+    std::uint32_t version() const {
+        return changeCount;
+    }
+};
+
+// Shortest-path distance from every cell of a NavGrid to one target cell,
+// and for each cell the neighbour one step closer. Steering an agent is then
+// a single lookup, so any number of agents chasing the same target share one
+// build. Distances are exact 8-way Dijkstra costs (10 straight, 14 diagonal,
+// no cutting past blocked corners).
+//
+// With a thread pool the grid is split into TILE_SIZE tiles, each settled by
+// its own Dijkstra from the distances on its borders. Tiles are processed in
+// four phases so that no two tiles running at once touch, and a tile whose
+// distances dropped wakes its neighbours, until no tile changes. The result
+// is the same as the single-threaded build.
+class FlowField {
+public:
+    static constexpr std::uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr int NO_DIRECTION = -1;
+    static constexpr int TILE_SIZE = 16;
+    // Below this many tiles a single Dijkstra beats waking the workers.
+    static constexpr int MIN_PARALLEL_TILES = 64;
+
+private:
+    struct HeapEntry {
+        std::uint32_t distance;
+        std::uint32_t cell;
+
+        bool operator<(const HeapEntry& other) const {
+            return distance > other.distance;
+        }
+    };
+
+    struct Rect {
+        int left, top, right, bottom;
+    };
+
+    static constexpr int STEP_X[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    static constexpr int STEP_Y[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    static constexpr std::uint32_t STEP_COST[8] = {10, 10, 10, 10, 14, 14, 14, 14};
+
+    int columns = 0;
+    int rows = 0;
+    float size = 32.0f;
+    int tilesX = 0;
+    int tilesY = 0;
+    int target = -1;
+    float goalX = 0.0f;
+    float goalY = 0.0f;
+    std::uint32_t gridVersion = 0;
+    std::uint64_t buildCount = 0;
+    bool seedPending = false;
+
+    std::vector<std::uint32_t> distances;
+    std::vector<std::int8_t> directions;
+    // Lowest distance a woken tile may receive; UNREACHABLE when asleep.
+    std::vector<std::uint32_t> tilePriority;
+    std::vector<std::uint32_t> tileLowest;
+    std::vector<std::uint32_t> phaseTiles;
+    // One heap per thread that can take part in a build; 0 is the caller.
+    std::vector<std::vector<HeapEntry>> heaps;
+
+    bool passable(const NavGrid& grid, int x, int y) const {
+        // The target may sit in a blocked cell, e.g. a player standing on
+        // the ground; it still has to seed the field.
+        return !grid.blocked(x, y) || y * columns + x == target;
+    }
+
+    bool canStep(const NavGrid& grid, int x, int y, int direction) const {
+        int nextX = x + STEP_X[direction];
+        int nextY = y + STEP_Y[direction];
+        if (nextX < 0 || nextY < 0 || nextX >= columns || nextY >= rows || !passable(grid, nextX, nextY)) {
+            return false;
+        }
+        if (direction >= 4) {
+            return passable(grid, nextX, y) && passable(grid, x, nextY);
+        }
+        return true;
+    }
+
+    static bool inside(const Rect& rect, int x, int y) {
+        return x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+    }
+
+    // Relaxes from the cells already in heap until it empties, never leaving
+    // rect.
+    void settle(const NavGrid& grid, const Rect& rect, std::vector<HeapEntry>& heap) {
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            HeapEntry entry = heap.back();
+            heap.pop_back();
+            if (entry.distance > distances[entry.cell]) continue;
+
+            int x = (int)entry.cell % columns;
+            int y = (int)entry.cell / columns;
+            for (int direction = 0; direction < 8; ++direction) {
+                int nextX = x + STEP_X[direction];
+                int nextY = y + STEP_Y[direction];
+                if (!inside(rect, nextX, nextY) || !canStep(grid, x, y, direction)) continue;
+                std::uint32_t next = (std::uint32_t)(nextY * columns + nextX);
+                std::uint32_t distance = entry.distance + STEP_COST[direction];
+                if (distance < distances[next]) {
+                    distances[next] = distance;
+                    heap.push_back(HeapEntry{distance, next});
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        }
+    }
+
+    // Pulls in whatever the neighbouring tiles now offer across the border,
+    // then settles the tile. Only reads cells outside it, which no tile
+    // running in the same phase writes. Returns the lowest distance that
+    // dropped, or UNREACHABLE if none did.
+    std::uint32_t processTile(const NavGrid& grid, std::uint32_t tile, std::vector<HeapEntry>& heap) {
+        int tileX = (int)tile % tilesX;
+        int tileY = (int)tile / tilesX;
+        Rect rect{tileX * TILE_SIZE, tileY * TILE_SIZE,
+                  std::min(columns, (tileX + 1) * TILE_SIZE), std::min(rows, (tileY + 1) * TILE_SIZE)};
+        heap.clear();
+        std::uint32_t lowest = UNREACHABLE;
+
+        if (inside(rect, target % columns, target / columns) && seedPending) {
+            seedPending = false;
+            heap.push_back(HeapEntry{0, (std::uint32_t)target});
+            lowest = 0;
+        }
+        for (int y = rect.top; y < rect.bottom; ++y) {
+            bool edgeRow = y == rect.top || y == rect.bottom - 1;
+            for (int x = rect.left; x < rect.right; x += edgeRow ? 1 : std::max(1, rect.right - rect.left - 1)) {
+                if (!passable(grid, x, y)) continue;
+                std::uint32_t cell = (std::uint32_t)(y * columns + x);
+                for (int direction = 0; direction < 8; ++direction) {
+                    int fromX = x + STEP_X[direction];
+                    int fromY = y + STEP_Y[direction];
+                    if (inside(rect, fromX, fromY) || !canStep(grid, x, y, direction)) continue;
+                    std::uint32_t from = distances[fromY * columns + fromX];
+                    if (from == UNREACHABLE) continue;
+                    std::uint32_t distance = from + STEP_COST[direction];
+                    if (distance < distances[cell]) {
+                        distances[cell] = distance;
+                        lowest = std::min(lowest, distance);
+                        heap.push_back(HeapEntry{distance, cell});
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+            }
+        }
+        settle(grid, rect, heap);
+        return lowest;
+    }
+
+    void activateAround(std::uint32_t tile, std::uint32_t distance) {
+        int tileX = (int)tile % tilesX;
+        int tileY = (int)tile / tilesX;
+        for (int y = std::max(0, tileY - 1); y <= std::min(tilesY - 1, tileY + 1); ++y) {
+            for (int x = std::max(0, tileX - 1); x <= std::min(tilesX - 1, tileX + 1); ++x) {
+                std::uint32_t& priority = tilePriority[y * tilesX + x];
+                if (x != tileX || y != tileY) priority = std::min(priority, distance);
+            }
+        }
+    }
+
+    // Each round only takes the woken tiles within one tile's crossing cost
+    // of the nearest, so tiles settle roughly in distance order, as a single
+    // Dijkstra would, instead of being redone as shorter paths arrive. The
+    // whole wavefront still runs at once.
+    void buildTiled(const NavGrid& grid, ThreadPool& pool) {
+        const std::uint32_t BAND = TILE_SIZE * 10;
+        std::fill(tilePriority.begin(), tilePriority.end(), UNREACHABLE);
+        tilePriority[(target / columns / TILE_SIZE) * tilesX + (target % columns) / TILE_SIZE] = 0;
+        seedPending = true;
+
+        for (;;) {
+            std::uint32_t nearest = *std::min_element(tilePriority.begin(), tilePriority.end());
+            if (nearest == UNREACHABLE) break;
+            std::uint32_t limit = nearest + BAND;
+
+            for (int phase = 0; phase < 4; ++phase) {
+                phaseTiles.clear();
+                for (int y = phase / 2; y < tilesY; y += 2) {
+                    for (int x = phase % 2; x < tilesX; x += 2) {
+                        std::uint32_t tile = (std::uint32_t)(y * tilesX + x);
+                        if (tilePriority[tile] > limit) continue;
+                        tilePriority[tile] = UNREACHABLE;
+                        phaseTiles.push_back(tile);
+                    }
+                }
+                if (phaseTiles.empty()) continue;
+
+                pool.parallelFor(phaseTiles.size(), [this, &grid](size_t index, size_t slot) {
+                    std::uint32_t tile = phaseTiles[index];
+                    tileLowest[tile] = processTile(grid, tile, heaps[slot]);
+                });
+                for (std::uint32_t tile : phaseTiles) {
+                    if (tileLowest[tile] != UNREACHABLE) activateAround(tile, tileLowest[tile]);
+                }
+            }
+        }
+    }
+
+    // Steepest descent. A cell the field never reached, such as a blocked
+    // one an agent was pushed into, points at its nearest reached neighbour
+    // so the agent can find its way back out.
+    void computeDirections(const NavGrid& grid, int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            for (int x = 0; x < columns; ++x) {
+                int cell = y * columns + x;
+                bool reached = distances[cell] != UNREACHABLE;
+                std::uint32_t best = distances[cell];
+                int bestDirection = NO_DIRECTION;
+                for (int direction = 0; direction < 8; ++direction) {
+                    int nextX = x + STEP_X[direction];
+                    int nextY = y + STEP_Y[direction];
+                    if (nextX < 0 || nextY < 0 || nextX >= columns || nextY >= rows) continue;
+                    if (reached && !canStep(grid, x, y, direction)) continue;
+                    std::uint32_t distance = distances[nextY * columns + nextX];
+                    if (distance < best) {
+                        best = distance;
+                        bestDirection = direction;
+                    }
+                }
+                directions[cell] = (std::int8_t)bestDirection;
+            }
+        }
+    }
+
+public:
+    // Rebuilds for the cell under (targetX, targetY), unconditionally.
+    void build(const NavGrid& grid, float targetX, float targetY, ThreadPool* pool = nullptr) {
+        columns = grid.width();
+        rows = grid.height();
+        size = grid.cellSize();
+        tilesX = (columns + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY = (rows + TILE_SIZE - 1) / TILE_SIZE;
+        target = grid.cellAt(targetX, targetY);
+        goalX = targetX;
+        goalY = targetY;
+        gridVersion = grid.version();
+        ++buildCount;
+
+        size_t cellCount = (size_t)columns * rows;
+        distances.assign(cellCount, UNREACHABLE);
+        directions.resize(cellCount);
+        tilePriority.resize((size_t)tilesX * tilesY);
+        tileLowest.resize((size_t)tilesX * tilesY);
+        heaps.resize(pool != nullptr ? pool->threadCount() + 1 : 1);
+        distances[target] = 0;
+
+        bool parallel = pool != nullptr && tilesX * tilesY >= MIN_PARALLEL_TILES;
+        if (parallel) {
+            buildTiled(grid, *pool);
+            const int ROWS_PER_TASK = TILE_SIZE;
+            pool->parallelFor((size_t)(rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [this, &grid](size_t index, size_t) {
+                int firstRow = (int)index * ROWS_PER_TASK;
+                computeDirections(grid, firstRow, std::min(rows, firstRow + ROWS_PER_TASK));
+            });
+        } else {
+            heaps[0].clear();
+            heaps[0].push_back(HeapEntry{0, (std::uint32_t)target});
+            settle(grid, Rect{0, 0, columns, rows}, heaps[0]);
+            computeDirections(grid, 0, rows);
+        }
+    }
+
+    // Rebuilds only if the target moved to another cell or the grid changed.
+    // Returns whether it rebuilt.
+    bool update(const NavGrid& grid, float targetX, float targetY, ThreadPool* pool = nullptr) {
+        goalX = targetX;
+        goalY = targetY;
+        if (buildCount > 0 && grid.version() == gridVersion && grid.width() == columns && grid.height() == rows &&
+            grid.cellAt(targetX, targetY) == target) {
+            return false;
+        }
+        build(grid, targetX, targetY, pool);
+        return true;
+    }
+
+    int cellAt(float x, float y) const {
+        int cellX = std::min(columns - 1, std::max(0, (int)std::floor(x / size)));
+        int cellY = std::min(rows - 1, std::max(0, (int)std::floor(y / size)));
+        return cellY * columns + cellX;
+    }
+
+    std::uint32_t distance(int cell) const {
+        return distances[cell];
+    }
+
+    int direction(int cell) const {
+        return directions[cell];
+    }
+
+    // Unit step towards the target from a world position; false at the
+    // target and where the target cannot be reached.
+    bool steer(float x, float y, float& directionX, float& directionY) const {
+        const float DIAGONAL = 0.70710678f;
+        if (buildCount == 0) return false;
+        int step = directions[cellAt(x, y)];
+        if (step == NO_DIRECTION) return false;
+        float scale = step >= 4 ? DIAGONAL : 1.0f;
+        directionX = STEP_X[step] * scale;
+        directionY = STEP_Y[step] * scale;
+        return true;
+    }
+
+    float targetX() const {
+        return goalX;
+    }
+
+    float targetY() const {
+        return goalY;
+    }
+
+    std::uint64_t builds() const {
+        return buildCount;
+    }
+};
+
+// Sets every NavAgent's Velocity from the field: one lookup per agent, so
+// the cost per step is the field's occasional rebuild plus O(agents).
+void flowFieldSteeringSystem(ECS& ecs, const FlowField& field) {
+    auto& agents = ecs.pool<NavAgent>();
+    auto& transforms = ecs.pool<Transform>();
+    auto& velocities = ecs.pool<Velocity>();
+    const Entity* entities = agents.entities();
+    const NavAgent* navAgents = agents.components();
+
+    for (size_t i = 0; i < agents.count(); ++i) {
+        Entity entity = entities[i];
+        if (!transforms.hasData(entity) || !velocities.hasData(entity)) continue;
+        const NavAgent& agent = navAgents[i];
+        const Transform& transform = transforms.getData(entity);
+        Velocity& velocity = velocities.getData(entity);
+
+        float directionX = 0.0f;
+        float directionY = 0.0f;
+        if (field.steer(transform.x + agent.radius, transform.y + agent.radius, directionX, directionY)) {
+            velocity.vx = directionX * agent.speed;
+            velocity.vy = directionY * agent.speed;
+        } else {
+            velocity.vx = 0.0f;
+            velocity.vy = 0.0f;
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "ECS.h"
 #include "Components.h"
+#include "Profiler.h"
+#include <cstdint>
 #include <vector>
 #include <algorithm>
 
@@ -85,7 +87,8 @@ void resolveCollision(Transform& transformA, Velocity& velocityA, const Collider
 }
 
 void gravitySystem(ECS& ecs, float deltaTime) {
-    auto entities = ecs.getEntitiesWithComponent<RigidBody>();
+    auto entities = ecs.getEntitiesWithComponent<RigidBody>(frameArena());
+    auto& reducedRates = ecs.pool<ReducedRate>();
     const float GRAVITY = 980.0f;
 
     for (Entity entity : entities) {
@@ -94,75 +97,108 @@ void gravitySystem(ECS& ecs, float deltaTime) {
         auto& rigidBody = ecs.getComponent<RigidBody>(entity);
         
         if (rigidBody.useGravity && !rigidBody.isStatic) {
+            float stepTime = deltaTime;
+            if (reducedRates.count() > 0 && reducedRates.hasData(entity)) {
+                stepTime = reducedRateStep(reducedRates.getData(entity), deltaTime);
+                if (stepTime == 0.0f) continue;
+            }
             auto& velocity = ecs.getComponent<Velocity>(entity);
-            velocity.vy += GRAVITY * rigidBody.gravityScale * deltaTime;
+            velocity.vy += GRAVITY * rigidBody.gravityScale * stepTime;
             const float MAX_FALL_SPEED = 900.0f;
             if (velocity.vy > MAX_FALL_SPEED) velocity.vy = MAX_FALL_SPEED;
         }
     }
 }
 
+// Bodies on a ReducedRate off-step did not move this step, so pairs of two
+// of them are skipped; they are still tested against bodies that did move.
 void physicsSystem(ECS& ecs, float deltaTime) {
-    auto entities = ecs.getEntitiesWithComponent<Collider>();
-    std::vector<CollisionPair> collisions;
-
-    for (size_t i = 0; i < entities.size(); ++i) {
-        for (size_t j = i + 1; j < entities.size(); ++j) {
-            Entity entityA = entities[i];
-            Entity entityB = entities[j];
-
-            if (!ecs.hasComponent<Transform>(entityA) || !ecs.hasComponent<Transform>(entityB)) {
-                continue;
-            }
+    auto entities = ecs.getEntitiesWithComponent<Collider>(frameArena());
+    FrameVector<CollisionPair> collisions = makeFrameVector<CollisionPair>(frameArena(), entities.size());
+    FrameVector<std::uint8_t> resting = makeFrameVector<std::uint8_t>(frameArena(), entities.size());
+    auto& reducedRates = ecs.pool<ReducedRate>();
+    for (Entity entity : entities) {
+        bool offStep = reducedRates.count() > 0 && reducedRates.hasData(entity) &&
+                       reducedRateStep(reducedRates.getData(entity), deltaTime) == 0.0f;
+        resting.push_back(offStep ? 1 : 0);
+    }
 
-            auto& transformA = ecs.getComponent<Transform>(entityA);
-            auto& transformB = ecs.getComponent<Transform>(entityB);
-            auto& colliderA = ecs.getComponent<Collider>(entityA);
-            auto& colliderB = ecs.getComponent<Collider>(entityB);
+    {
+        PROFILE_SCOPE("broadphase");
+        for (size_t i = 0; i < entities.size(); ++i) {
+            for (size_t j = i + 1; j < entities.size(); ++j) {
+                if (resting[i] && resting[j]) continue;
+                Entity entityA = entities[i];
+                Entity entityB = entities[j];
 
-            AABB boxA = getAABB(transformA, colliderA);
-            AABB boxB = getAABB(transformB, colliderB);
+                if (!ecs.hasComponent<Transform>(entityA) || !ecs.hasComponent<Transform>(entityB)) {
+                    continue;
+                }
 
-            if (checkAABBCollision(boxA, boxB)) {
+                auto& colliderA = ecs.getComponent<Collider>(entityA);
+                auto& colliderB = ecs.getComponent<Collider>(entityB);
                 if (colliderA.isTrigger || colliderB.isTrigger) {
                     continue;
                 }
 
-                bool hasVelocityA = ecs.hasComponent<Velocity>(entityA);
-                bool hasVelocityB = ecs.hasComponent<Velocity>(entityB);
-
-                if (hasVelocityA && hasVelocityB) {
-                    auto& velocityA = ecs.getComponent<Velocity>(entityA);
-                    auto& velocityB = ecs.getComponent<Velocity>(entityB);
-                    
-                    bool isStaticB = false;
-                    if (ecs.hasComponent<RigidBody>(entityB)) {
-                        isStaticB = ecs.getComponent<RigidBody>(entityB).isStatic;
-                    }
-
-                    resolveCollision(transformA, velocityA, colliderA, 
-                                   transformB, velocityB, colliderB, isStaticB);
-                } else if (hasVelocityA && !hasVelocityB) {
-                    auto& velocityA = ecs.getComponent<Velocity>(entityA);
-                    Velocity dummyVelocity = {0, 0};
-
-                    resolveCollision(transformA, velocityA, colliderA,
-                                   transformB, dummyVelocity, colliderB, true);
-                } else if (!hasVelocityA && hasVelocityB) {
-                    // Static entity is A, dynamic entity is B — swap roles
-                    auto& velocityB = ecs.getComponent<Velocity>(entityB);
-                    Velocity dummyVelocity = {0, 0};
-
-                    resolveCollision(transformB, velocityB, colliderB,
-                                   transformA, dummyVelocity, colliderA, true);
+                AABB boxA = getAABB(ecs.getComponent<Transform>(entityA), colliderA);
+                AABB boxB = getAABB(ecs.getComponent<Transform>(entityB), colliderB);
+
+                if (checkAABBCollision(boxA, boxB)) {
+                    collisions.push_back(CollisionPair{entityA, entityB});
                 }
             }
         }
     }
+
+    PROFILE_SCOPE("narrowphase");
+    for (const CollisionPair& pair : collisions) {
+        Entity entityA = pair.a;
+        Entity entityB = pair.b;
+
+        auto& transformA = ecs.getComponent<Transform>(entityA);
+        auto& transformB = ecs.getComponent<Transform>(entityB);
+        auto& colliderA = ecs.getComponent<Collider>(entityA);
+        auto& colliderB = ecs.getComponent<Collider>(entityB);
+
+        // An earlier resolution this step may already have separated the pair.
+        if (!checkAABBCollision(getAABB(transformA, colliderA), getAABB(transformB, colliderB))) {
+            continue;
+        }
+
+        bool hasVelocityA = ecs.hasComponent<Velocity>(entityA);
+        bool hasVelocityB = ecs.hasComponent<Velocity>(entityB);
+
+        if (hasVelocityA && hasVelocityB) {
+            auto& velocityA = ecs.getComponent<Velocity>(entityA);
+            auto& velocityB = ecs.getComponent<Velocity>(entityB);
+            
+            bool isStaticB = false;
+            if (ecs.hasComponent<RigidBody>(entityB)) {
+                isStaticB = ecs.getComponent<RigidBody>(entityB).isStatic;
+            }
+
+            resolveCollision(transformA, velocityA, colliderA, 
+                           transformB, velocityB, colliderB, isStaticB);
+        } else if (hasVelocityA && !hasVelocityB) {
+            auto& velocityA = ecs.getComponent<Velocity>(entityA);
+            Velocity dummyVelocity = {0, 0};
+
+            resolveCollision(transformA, velocityA, colliderA,
+                           transformB, dummyVelocity, colliderB, true);
+        } else if (!hasVelocityA && hasVelocityB) {
+            // Static entity is A, dynamic entity is B — swap roles
+            auto& velocityB = ecs.getComponent<Velocity>(entityB);
+            Velocity dummyVelocity = {0, 0};
+
+            resolveCollision(transformB, velocityB, colliderB,
+                           transformA, dummyVelocity, colliderA, true);
+        }
+    }
 }
 
 void playerControllerSystem(ECS& ecs, float deltaTime, const Uint8* keystate) {
-    auto entities = ecs.getEntitiesWithComponent<PlayerController>();
+    auto entities = ecs.getEntitiesWithComponent<PlayerController>(frameArena());
 
     for (Entity entity : entities) {
         if (!ecs.hasComponent<Transform>(entity) || !ecs.hasComponent<Velocity>(entity)) {
@@ -191,7 +227,8 @@ void playerControllerSystem(ECS& ecs, float deltaTime, const Uint8* keystate) {
 }
 
 void groundDetectionSystem(ECS& ecs) {
-    auto players = ecs.getEntitiesWithComponent<PlayerController>();
+    auto players = ecs.getEntitiesWithComponent<PlayerController>(frameArena());
+    auto colliders = ecs.getEntitiesWithComponent<Collider>(frameArena());
 
     for (Entity player : players) {
         if (!ecs.hasComponent<Transform>(player) || 
@@ -215,7 +252,6 @@ void groundDetectionSystem(ECS& ecs) {
         groundCheckBox.width = playerBox.width - 10;
         groundCheckBox.height = 5;
 
-        auto colliders = ecs.getEntitiesWithComponent<Collider>();
         for (Entity other : colliders) {
             if (other == player) continue;
 
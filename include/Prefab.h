@@ -0,0 +1,131 @@
+#pragma once
+#include "ECS.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+// The entities and packed component runs written by one instantiate call.
+// Lives in the calling thread's frame arena, so it is only valid until the
+// arena's next reset.
+class PrefabBatch {
+public:
+    struct Run {
+        std::type_index type;
+        void* components;
+    };
+
+private:
+    const Entity* entityList;
+    size_t count;
+    const Run* runs;
+    size_t runCount;
+
+public:
+    PrefabBatch(const Entity* entities, size_t count, const Run* runs, size_t runCount)
+        : entityList(entities), count(count), runs(runs), runCount(runCount) {}
+
+    size_t size() const {
+        return count;
+    }
+
+    Entity entity(size_t index) const {
+        return entityList[index];
+    }
+
+    const Entity* entities() const {
+        return entityList;
+    }
+
+    // components<T>()[i] belongs to entity(i). nullptr if the prefab has no T.
+    template<typename T>
+    T* components() const {
+        for (size_t i = 0; i < runCount; ++i) {
+            if (runs[i].type == std::type_index(typeid(T))) return (T*)runs[i].components;
+        }
+        return nullptr;
+    }
+};
+
+// A named set of component defaults. Instantiating it creates entities with
+// exactly these components, each pool written once per batch.
+class Prefab {
+private:
+    struct Entry {
+        std::type_index type;
+        std::vector<std::uint8_t> value;
+        void* (*append)(ECS& ecs, const Entity* entities, size_t count, const void* value);
+    };
+
+    std::string prefabName;
+    std::vector<Entry> entries;
+
+public:
+    explicit Prefab(std::string name) : prefabName(std::move(name)) {}
+
+    // Adds T with the given defaults, or replaces T's defaults.
+    template<typename T>
+    Prefab& with(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "prefab defaults are copied as raw bytes");
+
+        const std::uint8_t* bytes = (const std::uint8_t*)&value;
+        for (Entry& entry : entries) {
+            if (entry.type == std::type_index(typeid(T))) {
+                entry.value.assign(bytes, bytes + sizeof(T));
+                return *this;
+            }
+        }
+        entries.push_back(Entry{
+            std::type_index(typeid(T)),
+            std::vector<std::uint8_t>(bytes, bytes + sizeof(T)),
+            [](ECS& ecs, const Entity* entities, size_t count, const void* value) -> void* {
+                T component;
+                std::memcpy(&component, value, sizeof(T));
+                return ecs.pool<T>().appendFilled(entities, count, component);
+            }
+        });
+        return *this;
+    }
+
+    const std::string& name() const {
+        return prefabName;
+    }
+
+    size_t componentCount() const {
+        return entries.size();
+    }
+
+    // Creates count entities and fills every component pool in one run each.
+    PrefabBatch instantiate(ECS& ecs, size_t count) const {
+        FrameArena& arena = frameArena();
+        Entity* entities = (Entity*)arena.allocate(std::max<size_t>(1, count) * sizeof(Entity), alignof(Entity));
+        PrefabBatch::Run* runs = (PrefabBatch::Run*)arena.allocate(
+            std::max<size_t>(1, entries.size()) * sizeof(PrefabBatch::Run), alignof(PrefabBatch::Run));
+
+        ecs.createEntities(entities, count);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry& entry = entries[i];
+            new (&runs[i]) PrefabBatch::Run{entry.type, entry.append(ecs, entities, count, entry.value.data())};
+        }
+        return PrefabBatch(entities, count, runs, entries.size());
+    }
+};
+
+// Instantiates count copies of prefab, then hands the batch to init to
+// overwrite per-instance fields through the packed runs.
+template<typename InitFn>
+PrefabBatch instantiate(ECS& ecs, const Prefab& prefab, size_t count, InitFn&& init) {
+    PrefabBatch batch = prefab.instantiate(ecs, count);
+    init(batch);
+    return batch;
+}
+
+PrefabBatch instantiate(ECS& ecs, const Prefab& prefab, size_t count) {
+    return prefab.instantiate(ecs, count);
+}
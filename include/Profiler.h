@@ -0,0 +1,227 @@
+#pragma once
+#include <SDL.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ProfileEvent {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+};
+
+// Single-writer ring owned by one thread. Readers copy the live window and
+// then drop whatever the writer may have overwritten while they copied, so
+// recording never takes a lock.
+class ProfileThreadBuffer {
+public:
+    static constexpr std::uint64_t CAPACITY = 16384;
+
+    std::string threadName;
+    int threadId;
+
+private:
+    std::array<ProfileEvent, CAPACITY> events;
+    std::atomic<std::uint64_t> written{0};
+
+public:
+    ProfileThreadBuffer(const std::string& threadName, int threadId)
+        : threadName(threadName), threadId(threadId) {}
+
+    void push(const ProfileEvent& event) {
+        std::uint64_t index = written.load(std::memory_order_relaxed);
+        events[index % CAPACITY] = event;
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    void copyEvents(std::vector<ProfileEvent>& out, Uint64 since) const {
+        std::uint64_t end = written.load(std::memory_order_acquire);
+        std::uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+        size_t first = out.size();
+        for (std::uint64_t i = begin; i < end; ++i) {
+            out.push_back(events[i % CAPACITY]);
+        }
+
+        // Slot i is reused by event i + CAPACITY, which may be mid-write once
+        // the writer has reached that index.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t after = written.load(std::memory_order_relaxed);
+        if (after >= begin + CAPACITY) {
+            size_t overwritten = (size_t)std::min<std::uint64_t>(after - CAPACITY - begin + 1, end - begin);
+            out.erase(out.begin() + first, out.begin() + first + overwritten);
+        }
+
+        out.erase(std::remove_if(out.begin() + first, out.end(),
+                                 [since](const ProfileEvent& event) { return event.start < since; }),
+                  out.end());
+    }
+};
+
+struct ProfileSummaryEntry {
+    std::string name;
+    std::string threadName;
+    double averageMs;
+    double maxMs;
+    int calls;
+};
+
+class Profiler {
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileThreadBuffer>> buffers;
+
+    ProfileThreadBuffer* registerThread(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int threadId = (int)buffers.size() + 1;
+        buffers.push_back(std::make_unique<ProfileThreadBuffer>(
+            name.empty() ? "Thread " + std::to_string(threadId) : name, threadId));
+        return buffers.back().get();
+    }
+
+    ProfileThreadBuffer*& currentThreadBuffer() {
+        static thread_local ProfileThreadBuffer* buffer = nullptr;
+        return buffer;
+    }
+
+public:
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    ProfileThreadBuffer& threadBuffer() {
+        ProfileThreadBuffer*& buffer = currentThreadBuffer();
+        if (buffer == nullptr) {
+            buffer = registerThread("");
+        }
+        return *buffer;
+    }
+
+    void setThreadName(const char* name) {
+        ProfileThreadBuffer*& buffer = currentThreadBuffer();
+        if (buffer == nullptr) {
+            buffer = registerThread(name);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer->threadName = name;
+        }
+    }
+
+    // Average and worst duration of every scope recorded in the last
+    // windowSeconds, sorted by thread then by average cost.
+    void summarize(double windowSeconds, std::vector<ProfileSummaryEntry>& out) {
+        out.clear();
+        Uint64 now = SDL_GetPerformanceCounter();
+        double frequency = (double)SDL_GetPerformanceFrequency();
+        Uint64 window = (Uint64)(windowSeconds * frequency);
+        Uint64 since = now > window ? now - window : 0;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ProfileEvent> events;
+        for (const auto& buffer : buffers) {
+            events.clear();
+            buffer->copyEvents(events, since);
+
+            std::unordered_map<std::string, size_t> entryIndex;
+            size_t first = out.size();
+            for (const ProfileEvent& event : events) {
+                double ms = (double)(event.end - event.start) * 1000.0 / frequency;
+                auto it = entryIndex.find(event.name);
+                if (it == entryIndex.end()) {
+                    entryIndex[event.name] = out.size();
+                    out.push_back(ProfileSummaryEntry{event.name, buffer->threadName, ms, ms, 1});
+                } else {
+                    ProfileSummaryEntry& entry = out[it->second];
+                    entry.averageMs += ms;
+                    entry.maxMs = std::max(entry.maxMs, ms);
+                    entry.calls++;
+                }
+            }
+
+            for (size_t i = first; i < out.size(); ++i) {
+                out[i].averageMs /= out[i].calls;
+            }
+            std::sort(out.begin() + first, out.end(),
+                      [](const ProfileSummaryEntry& a, const ProfileSummaryEntry& b) {
+                          return a.averageMs > b.averageMs;
+                      });
+        }
+    }
+
+    // Writes everything still in the rings as Chrome trace "complete" events
+    // (load in chrome://tracing or Perfetto).
+    bool writeChromeTrace(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr) return false;
+
+        double microsecondsPerCount = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ProfileEvent> events;
+        Uint64 origin = ~(Uint64)0;
+        for (const auto& buffer : buffers) {
+            events.clear();
+            buffer->copyEvents(events, 0);
+            for (const ProfileEvent& event : events) {
+                origin = std::min(origin, event.start);
+            }
+        }
+
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool firstEvent = true;
+        for (const auto& buffer : buffers) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    firstEvent ? "" : ",\n", buffer->threadId, buffer->threadName.c_str());
+            firstEvent = false;
+
+            events.clear();
+            buffer->copyEvents(events, 0);
+            for (const ProfileEvent& event : events) {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.name, buffer->threadId,
+                        (double)(event.start - origin) * microsecondsPerCount,
+                        (double)(event.end - event.start) * microsecondsPerCount);
+            }
+        }
+        fprintf(file, "\n]}\n");
+
+        return fclose(file) == 0;
+    }
+};
+
+class ProfileScope {
+private:
+    const char* name;
+    Uint64 start;
+
+public:
+    explicit ProfileScope(const char* name)
+        : name(name), start(SDL_GetPerformanceCounter()) {}
+
+    ~ProfileScope() {
+        Profiler::instance().threadBuffer().push(ProfileEvent{name, start, SDL_GetPerformanceCounter()});
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Markers vanish entirely unless the build defines GAME_ENGINE_PROFILING.
+#ifdef GAME_ENGINE_PROFILING
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::instance().setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// xorshift32 with its state held by the owner, so each world draws from its
+// own sequence instead of rand()'s hidden process-wide one. Worlds stepped on
+// different threads neither race on it nor change each other's results, and
+// the same seed always replays the same sequence.
+class Random {
+private:
+    std::uint32_t state;
+
+public:
+    explicit Random(std::uint32_t seed = 1) : state(seed != 0 ? seed : 1) {}
+
+    std::uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // In [0, bound).
+    int below(int bound) {
+        return (int)(next() % (std::uint32_t)bound);
+    }
+};
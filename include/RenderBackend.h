@@ -0,0 +1,126 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <vector>
+
+// Everything the render path draws goes through this interface, so the same
+// renderSystem/HUD code can target the GPU renderer or the CPU rasterizer.
+// Texture handles are opaque; Sprite::texture stores whatever the active
+// backend returned from createTexture.
+class RenderBackend {
+protected:
+    size_t textureMemory = 0;
+
+public:
+    virtual ~RenderBackend() = default;
+
+    // Pixel bytes held by live textures and render targets, at 4 bytes per
+    // texel (driver-side padding and mipmaps are not visible from here).
+    size_t textureBytes() const {
+        return textureMemory;
+    }
+
+    virtual void* createTexture(SDL_Surface* surface) = 0;
+    virtual void* createRenderTarget(int width, int height) = 0;
+    virtual void destroyTexture(void* texture) = 0;
+    virtual void setRenderTarget(void* target) = 0;
+
+    virtual void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) = 0;
+    virtual void clear() = 0;
+    virtual void fillRect(const SDL_Rect& rect) = 0;
+    virtual void drawRect(const SDL_Rect& rect) = 0;
+    virtual void drawTexture(void* texture, const SDL_Rect* srcRect, const SDL_Rect& destRect, double rotation) = 0;
+
+    virtual void present() = 0;
+    virtual bool saveFrame(const char* path) = 0;
+};
+
+class SDLRenderBackend : public RenderBackend {
+private:
+    SDL_Renderer* renderer;
+    int width;
+    int height;
+
+public:
+    SDLRenderBackend(SDL_Renderer* renderer, int width, int height)
+        : renderer(renderer), width(width), height(height) {}
+
+    SDL_Renderer* sdlRenderer() const {
+        return renderer;
+    }
+
+    void* createTexture(SDL_Surface* surface) override {
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        if (texture != nullptr) {
+            textureMemory += (size_t)surface->w * surface->h * 4;
+        }
+        return texture;
+    }
+
+    void* createRenderTarget(int targetWidth, int targetHeight) override {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                                 SDL_TEXTUREACCESS_TARGET, targetWidth, targetHeight);
+        if (texture != nullptr) {
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+            textureMemory += (size_t)targetWidth * targetHeight * 4;
+        }
+        return texture;
+    }
+
+    void destroyTexture(void* texture) override {
+        if (texture == nullptr) return;
+
+        int textureWidth = 0;
+        int textureHeight = 0;
+        if (SDL_QueryTexture((SDL_Texture*)texture, nullptr, nullptr, &textureWidth, &textureHeight) == 0) {
+            textureMemory -= std::min(textureMemory, (size_t)textureWidth * textureHeight * 4);
+        }
+        SDL_DestroyTexture((SDL_Texture*)texture);
+    }
+
+    void setRenderTarget(void* target) override {
+        SDL_SetRenderTarget(renderer, (SDL_Texture*)target);
+    }
+
+    void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) override {
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    }
+
+    void clear() override {
+        SDL_RenderClear(renderer);
+    }
+
+    void fillRect(const SDL_Rect& rect) override {
+        SDL_RenderFillRect(renderer, &rect);
+    }
+
+    void drawRect(const SDL_Rect& rect) override {
+        SDL_RenderDrawRect(renderer, &rect);
+    }
+
+    void drawTexture(void* texture, const SDL_Rect* srcRect, const SDL_Rect& destRect, double rotation) override {
+        if (rotation == 0.0) {
+            SDL_RenderCopy(renderer, (SDL_Texture*)texture, srcRect, &destRect);
+        } else {
+            SDL_RenderCopyEx(renderer, (SDL_Texture*)texture, srcRect, &destRect, rotation, NULL, SDL_FLIP_NONE);
+        }
+    }
+
+    void present() override {
+        SDL_RenderPresent(renderer);
+    }
+
+    bool saveFrame(const char* path) override {
+        std::vector<Uint32> pixels((size_t)width * height);
+        if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels.data(), width * 4) != 0) {
+            return false;
+        }
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), width, height, 32,
+                                                                  width * 4, SDL_PIXELFORMAT_RGBA32);
+        if (surface == nullptr) return false;
+        bool saved = IMG_SavePNG(surface, path) == 0;
+        SDL_FreeSurface(surface);
+        return saved;
+    }
+};
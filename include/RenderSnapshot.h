@@ -0,0 +1,237 @@
+#pragma once
+#include "ECS.h"
+#include "Components.h"
+#include "AnimationSystem.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct SpriteDraw {
+    Entity entity;
+    int layer;
+    float depth;
+    void* texture;
+    float x;
+    float y;
+    float prevX;
+    float prevY;
+    float rotation;
+    int width;
+    int height;
+    int srcX;
+    int srcY;
+    int srcWidth;
+    int srcHeight;
+};
+
+struct ParticleDraw {
+    Entity entity;
+    float x;
+    float y;
+    float prevX;
+    float prevY;
+    std::uint8_t r;
+    std::uint8_t g;
+    std::uint8_t b;
+    std::uint8_t a;
+};
+
+struct RectDraw {
+    Entity entity;
+    float x;
+    float y;
+    float prevX;
+    float prevY;
+    float width;
+    float height;
+};
+
+struct HudState {
+    int health;
+    int maxHealth;
+    float playerX;
+    float playerY;
+};
+
+// Everything the renderer needs from one simulation tick. Buffers are cleared,
+// not freed, between ticks so steady-state publishing does not allocate.
+struct RenderSnapshot {
+    std::uint64_t tick = 0;
+    float cameraX = 0.0f;
+    float cameraY = 0.0f;
+    float prevCameraX = 0.0f;
+    float prevCameraY = 0.0f;
+    // Fraction of a step already accumulated when this snapshot was published,
+    // and the performance counter value at that moment; the renderer adds the
+    // time elapsed since to get its interpolation factor.
+    float interpolationBase = 1.0f;
+    float stepSeconds = 0.0f;
+    std::uint64_t publishCounter = 0;
+    // Heap allocations made by the simulation thread while producing the
+    // previous snapshot.
+    std::uint64_t simulationAllocations = 0;
+    std::vector<SpriteDraw> sprites;
+    std::vector<ParticleDraw> particles;
+    std::vector<RectDraw> platforms;
+    std::vector<RectDraw> bodies;
+    std::vector<RectDraw> colliders;
+    HudState hud{};
+};
+
+// Lock-free single-producer/single-consumer triple buffer. The producer always
+// has a private slot to write into and the consumer always reads the most
+// recently published slot, so neither side ever waits on the other.
+template<typename T>
+class TripleBuffer {
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int FRESH_BIT = 0x4;
+
+    std::array<T, 3> buffers;
+    std::atomic<int> middle{1};
+    int writeIndex = 0;
+    int readIndex = 2;
+
+public:
+    T& writeBuffer() {
+        return buffers[writeIndex];
+    }
+
+    void publish() {
+        int previous = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    bool acquire() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH_BIT)) {
+            return false;
+        }
+        int previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const {
+        return buffers[readIndex];
+    }
+};
+
+void previousPosition(ECS& ecs, Entity entity, const Transform& transform, float& x, float& y) {
+    if (ecs.hasComponent<PreviousTransform>(entity)) {
+        auto& previous = ecs.getComponent<PreviousTransform>(entity);
+        x = previous.x;
+        y = previous.y;
+    } else {
+        x = transform.x;
+        y = transform.y;
+    }
+}
+
+void buildRenderSnapshot(ECS& ecs, Entity player, float simulationTime, RenderSnapshot& snapshot) {
+    snapshot.sprites.clear();
+    snapshot.particles.clear();
+    snapshot.platforms.clear();
+    snapshot.bodies.clear();
+    snapshot.colliders.clear();
+
+    for (Entity entity : ecs.getEntitiesWithComponent<Sprite>(frameArena())) {
+        if (!ecs.hasComponent<Transform>(entity)) continue;
+
+        auto& transform = ecs.getComponent<Transform>(entity);
+        auto& sprite = ecs.getComponent<Sprite>(entity);
+
+        int layer = RENDER_LAYER_SPRITES;
+        float depth = 0.0f;
+        if (ecs.hasComponent<RenderLayer>(entity)) {
+            auto& renderLayer = ecs.getComponent<RenderLayer>(entity);
+            layer = renderLayer.layer;
+            depth = renderLayer.depth;
+        }
+
+        float prevX;
+        float prevY;
+        previousPosition(ecs, entity, transform, prevX, prevY);
+
+        snapshot.sprites.push_back(SpriteDraw{
+            entity,
+            layer,
+            depth,
+            resolveSpriteTexture(sprite),
+            transform.x,
+            transform.y,
+            prevX,
+            prevY,
+            transform.rotation,
+            (int)(sprite.width * transform.scaleX),
+            (int)(sprite.height * transform.scaleY),
+            sprite.srcX,
+            sprite.srcY,
+            sprite.srcWidth,
+            sprite.srcHeight
+        });
+    }
+
+    for (Entity entity : ecs.getEntitiesWithComponent<Particle>(frameArena())) {
+        if (!ecs.hasComponent<Transform>(entity)) continue;
+
+        auto& transform = ecs.getComponent<Transform>(entity);
+        auto& particle = ecs.getComponent<Particle>(entity);
+
+        float prevX;
+        float prevY;
+        previousPosition(ecs, entity, transform, prevX, prevY);
+
+        snapshot.particles.push_back(ParticleDraw{
+            entity,
+            transform.x,
+            transform.y,
+            prevX,
+            prevY,
+            (std::uint8_t)particle.colorR,
+            (std::uint8_t)particle.colorG,
+            (std::uint8_t)particle.colorB,
+            (std::uint8_t)particleAlpha(particle, simulationTime)
+        });
+    }
+
+    for (Entity entity : ecs.getEntitiesWithComponent<Collider>(frameArena())) {
+        if (!ecs.hasComponent<Transform>(entity)) continue;
+
+        auto& transform = ecs.getComponent<Transform>(entity);
+        auto& collider = ecs.getComponent<Collider>(entity);
+
+        float prevX;
+        float prevY;
+        previousPosition(ecs, entity, transform, prevX, prevY);
+
+        RectDraw rect{
+            entity,
+            transform.x + collider.offsetX,
+            transform.y + collider.offsetY,
+            prevX + collider.offsetX,
+            prevY + collider.offsetY,
+            collider.width,
+            collider.height
+        };
+        snapshot.colliders.push_back(rect);
+
+        if (ecs.hasComponent<RigidBody>(entity) && !ecs.hasComponent<Sprite>(entity)) {
+            RectDraw body{entity, transform.x, transform.y, prevX, prevY, collider.width, collider.height};
+            if (ecs.getComponent<RigidBody>(entity).isStatic) {
+                snapshot.platforms.push_back(body);
+            } else {
+                snapshot.bodies.push_back(body);
+            }
+        }
+    }
+
+    auto& playerTransform = ecs.getComponent<Transform>(player);
+    auto& playerHealth = ecs.getComponent<Health>(player);
+    snapshot.hud = HudState{
+        playerHealth.current,
+        playerHealth.max,
+        playerTransform.x,
+        playerTransform.y
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "RenderBackend.h"
+#include "RenderSnapshot.h"
+#include "DrawQueue.h"
+#include <SDL.h>
+
+struct Camera {
+    float x;
+    float y;
+    int width;
+    int height;
+};
+
+float interpolate(float previous, float current, float alpha) {
+    return previous + (current - previous) * alpha;
+}
+
+void renderSprite(const SpriteDraw& sprite, RenderBackend& backend, const Camera& camera, float alpha) {
+    int screenX = (int)(interpolate(sprite.prevX, sprite.x, alpha) - camera.x);
+    int screenY = (int)(interpolate(sprite.prevY, sprite.y, alpha) - camera.y);
+    
+    SDL_Rect destRect = {screenX, screenY, sprite.width, sprite.height};
+    
+    SDL_Rect srcRect = {sprite.srcX, sprite.srcY, sprite.srcWidth, sprite.srcHeight};
+    
+    if (sprite.srcWidth == 0 || sprite.srcHeight == 0) {
+        backend.drawTexture(sprite.texture, NULL, destRect, sprite.rotation);
+    } else {
+        backend.drawTexture(sprite.texture, &srcRect, destRect, sprite.rotation);
+    }
+}
+
+void renderParticle(const ParticleDraw& particle, RenderBackend& backend, const Camera& camera, float alpha) {
+    int screenX = (int)(interpolate(particle.prevX, particle.x, alpha) - camera.x);
+    int screenY = (int)(interpolate(particle.prevY, particle.y, alpha) - camera.y);
+    
+    backend.setDrawColor(particle.r, particle.g, particle.b, particle.a);
+    
+    SDL_Rect rect = {screenX, screenY, 8, 8};
+    backend.fillRect(rect);
+}
+
+void renderBody(const RectDraw& body, RenderBackend& backend, const Camera& camera, float alpha) {
+    int screenX = (int)(interpolate(body.prevX, body.x, alpha) - camera.x);
+    int screenY = (int)(interpolate(body.prevY, body.y, alpha) - camera.y);
+    
+    SDL_Rect rect = {screenX, screenY, (int)body.width, (int)body.height};
+    backend.fillRect(rect);
+}
+
+void debugRenderCollider(const RectDraw& collider, RenderBackend& backend, const Camera& camera, float alpha) {
+    int screenX = (int)(interpolate(collider.prevX, collider.x, alpha) - camera.x);
+    int screenY = (int)(interpolate(collider.prevY, collider.y, alpha) - camera.y);
+    
+    SDL_Rect rect = {screenX, screenY, (int)collider.width, (int)collider.height};
+    backend.drawRect(rect);
+}
+
+void renderSystem(const DrawQueue& drawQueue, const RenderSnapshot& snapshot,
+                  RenderBackend& backend, const Camera& camera, float alpha) {
+    bool colorIsStale = true;
+    DrawKind previousKind = DrawKind::Sprite;
+
+    for (const DrawCommand& command : drawQueue.sorted()) {
+        if (command.kind != previousKind) {
+            colorIsStale = true;
+            previousKind = command.kind;
+        }
+
+        switch (command.kind) {
+            case DrawKind::Body:
+                if (colorIsStale) {
+                    backend.setDrawColor(100, 100, 120, 255);
+                    colorIsStale = false;
+                }
+                renderBody(snapshot.bodies[command.index], backend, camera, alpha);
+                break;
+            case DrawKind::Particle:
+                renderParticle(snapshot.particles[command.index], backend, camera, alpha);
+                break;
+            case DrawKind::Sprite:
+                renderSprite(snapshot.sprites[command.index], backend, camera, alpha);
+                break;
+            case DrawKind::ColliderOutline:
+                if (colorIsStale) {
+                    backend.setDrawColor(0, 255, 0, 255);
+                    colorIsStale = false;
+                }
+                debugRenderCollider(snapshot.colliders[command.index], backend, camera, alpha);
+                break;
+        }
+    }
+}
@@ -0,0 +1,529 @@
+#pragma once
+#include "ECS.h"
+#include "Components.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary scene format, version 1, little-endian:
+//
+//   SceneFileHeader                        64 bytes at offset 0
+//   living entity IDs                      uint32[livingCount]
+//   ScenePoolEntry table                   64 bytes per pool
+//   texture path table                     per path: uint32 length + bytes
+//   per pool: packed components            componentSize * count bytes
+//             owning entity IDs            uint32[count]
+//
+// Every section starts on a SCENE_BLOCK_ALIGNMENT boundary, so a mapped file
+// can be handed to the pools as-is: loading a pool is two memcpys plus the
+// rebuild of its entity -> index table, whatever the entity count. Components
+// are stored in their in-memory layout; a pool whose size in the file does not
+// match sizeof the registered type is rejected rather than converted.
+constexpr char SCENE_FILE_MAGIC[4] = {'G', 'E', 'S', 'C'};
+constexpr std::uint32_t SCENE_FILE_VERSION = 1;
+constexpr std::uint32_t SCENE_BYTE_ORDER_MARK = 0x01020304u;
+constexpr size_t SCENE_BLOCK_ALIGNMENT = 64;
+constexpr size_t SCENE_COMPONENT_NAME_LENGTH = 32;
+
+struct SceneFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t entityCapacity;
+    std::uint32_t livingCount;
+    std::uint32_t poolCount;
+    std::uint32_t textureCount;
+    std::uint32_t reserved;
+    std::uint64_t livingOffset;
+    std::uint64_t poolTableOffset;
+    std::uint64_t textureTableOffset;
+    std::uint64_t fileSize;
+};
+
+struct ScenePoolEntry {
+    char name[SCENE_COMPONENT_NAME_LENGTH];
+    std::uint32_t componentSize;
+    std::uint32_t count;
+    std::uint64_t componentsOffset;
+    std::uint64_t entitiesOffset;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(SceneFileHeader) == 64, "scene header layout changed");
+static_assert(sizeof(ScenePoolEntry) == 64, "scene pool entry layout changed");
+
+bool hostIsLittleEndian() {
+    const std::uint32_t probe = 1;
+    std::uint8_t firstByte;
+    std::memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+// Textures are stored by path. Index 0 means "no texture", so a table entry
+// at position i is referenced as i + 1. An entry may carry a loader asset as
+// well as (or instead of) a raw texture; sprites loaded against it get both.
+struct SceneTextures {
+    std::vector<std::string> paths;
+    std::vector<void*> textures;
+    std::vector<const TextureAsset*> assets;
+
+    void add(const std::string& path, void* texture, const TextureAsset* asset = nullptr) {
+        paths.push_back(path);
+        textures.push_back(texture);
+        assets.push_back(asset);
+    }
+
+    std::uint32_t indexOf(const Sprite& sprite) const {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (sprite.asset != nullptr ? assets[i] == sprite.asset
+                                        : sprite.texture != nullptr && textures[i] == sprite.texture) {
+                return (std::uint32_t)(i + 1);
+            }
+        }
+        return 0;
+    }
+
+    void* textureAt(std::uint32_t index) const {
+        return index > 0 && index <= textures.size() ? textures[index - 1] : nullptr;
+    }
+
+    const TextureAsset* assetAt(std::uint32_t index) const {
+        return index > 0 && index <= assets.size() ? assets[index - 1] : nullptr;
+    }
+
+    size_t find(const std::string& path) const {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (paths[i] == path) return i;
+        }
+        return paths.size();
+    }
+};
+
+// Per-type patching for fields that cannot be stored verbatim. Runs over the
+// packed array after the bulk copy, never per entity through the ECS.
+template<typename T>
+struct SceneComponentFixup {
+    static void save(T*, size_t, const SceneTextures&) {}
+    static void load(T*, size_t, const SceneTextures&) {}
+};
+
+template<>
+struct SceneComponentFixup<Sprite> {
+    static void save(Sprite* sprites, size_t count, const SceneTextures& textures) {
+        for (size_t i = 0; i < count; ++i) {
+            sprites[i].texture = (void*)(std::uintptr_t)textures.indexOf(sprites[i]);
+            sprites[i].asset = nullptr;
+        }
+    }
+
+    static void load(Sprite* sprites, size_t count, const SceneTextures& textures) {
+        for (size_t i = 0; i < count; ++i) {
+            std::uint32_t index = (std::uint32_t)(std::uintptr_t)sprites[i].texture;
+            sprites[i].texture = textures.textureAt(index);
+            sprites[i].asset = textures.assetAt(index);
+        }
+    }
+};
+
+// Per-type rewriting of fields that hold entity IDs, for formats that store
+// a subset of the world under its own numbering. table maps old IDs to new;
+// IDs past its end, or mapped to INVALID_ENTITY, become INVALID_ENTITY.
+template<typename T>
+struct SceneEntityFixup {
+    static void remap(T*, size_t, const Entity*, size_t) {}
+};
+
+template<>
+struct SceneEntityFixup<Parent> {
+    static void remap(Parent* parents, size_t count, const Entity* table, size_t tableSize) {
+        for (size_t i = 0; i < count; ++i) {
+            parents[i].entity = parents[i].entity < tableSize ? table[parents[i].entity] : INVALID_ENTITY;
+        }
+    }
+};
+
+struct SceneComponentType {
+    std::string name;
+    std::uint32_t size;
+    bool (*hasPool)(const ECS& ecs);
+    void (*save)(ECS& ecs, const SceneTextures& textures,
+                 std::vector<std::uint8_t>& components, std::vector<Entity>& entities);
+    void (*load)(ECS& ecs, const std::uint8_t* components, const Entity* entities, size_t count,
+                 const SceneTextures& textures);
+    // Subset save: the components of the given entities, with owners stored
+    // as positions in that list and entity fields renumbered through
+    // localIndex (indexed by entity ID).
+    void (*saveEntities)(ECS& ecs, const Entity* entities, size_t count, const Entity* localIndex,
+                         const SceneTextures& textures, std::vector<std::uint8_t>& components,
+                         std::vector<Entity>& owners);
+    // Inverse of saveEntities into a live ECS: owner i becomes created[i].
+    void (*instantiate)(ECS& ecs, const std::uint8_t* components, const Entity* owners, size_t count,
+                        const Entity* created, size_t createdCount, const SceneTextures& textures);
+};
+
+// Maps the names stored in scene files to component types. Names, not
+// type_index, identify pools on disk so files survive recompiles.
+class SceneRegistry {
+private:
+    std::vector<SceneComponentType> types;
+
+public:
+    template<typename T>
+    void registerComponent(const char* name) {
+        static_assert(std::is_trivially_copyable<T>::value, "scene components are copied as raw bytes");
+
+        SceneComponentType type;
+        type.name = name;
+        type.size = (std::uint32_t)sizeof(T);
+        type.hasPool = [](const ECS& ecs) {
+            return ecs.components().hasPool<T>();
+        };
+        type.save = [](ECS& ecs, const SceneTextures& textures,
+                       std::vector<std::uint8_t>& components, std::vector<Entity>& entities) {
+            ComponentArrayImpl<T>& pool = ecs.pool<T>();
+            components.resize(pool.count() * sizeof(T));
+            if (pool.count() > 0) {
+                std::memcpy(components.data(), pool.components(), components.size());
+            }
+            entities.assign(pool.entities(), pool.entities() + pool.count());
+            SceneComponentFixup<T>::save((T*)components.data(), pool.count(), textures);
+        };
+        type.load = [](ECS& ecs, const std::uint8_t* components, const Entity* entities, size_t count,
+                       const SceneTextures& textures) {
+            ComponentArrayImpl<T>& pool = ecs.pool<T>();
+            pool.assignPacked((const T*)components, entities, count);
+            SceneComponentFixup<T>::load(pool.components(), count, textures);
+        };
+        type.saveEntities = [](ECS& ecs, const Entity* entities, size_t count, const Entity* localIndex,
+                               const SceneTextures& textures, std::vector<std::uint8_t>& components,
+                               std::vector<Entity>& owners) {
+            components.clear();
+            owners.clear();
+            if (!ecs.components().hasPool<T>()) return;
+            ComponentArrayImpl<T>& pool = ecs.pool<T>();
+            for (size_t i = 0; i < count; ++i) {
+                if (!pool.hasData(entities[i])) continue;
+                const std::uint8_t* bytes = (const std::uint8_t*)&pool.getData(entities[i]);
+                components.insert(components.end(), bytes, bytes + sizeof(T));
+                owners.push_back((Entity)i);
+            }
+            SceneComponentFixup<T>::save((T*)components.data(), owners.size(), textures);
+            SceneEntityFixup<T>::remap((T*)components.data(), owners.size(), localIndex, ecs.entities().capacity());
+        };
+        type.instantiate = [](ECS& ecs, const std::uint8_t* components, const Entity* owners, size_t count,
+                              const Entity* created, size_t createdCount, const SceneTextures& textures) {
+            ComponentArrayImpl<T>& pool = ecs.pool<T>();
+            for (size_t i = 0; i < count; ++i) {
+                T component;
+                std::memcpy(&component, components + i * sizeof(T), sizeof(T));
+                SceneComponentFixup<T>::load(&component, 1, textures);
+                SceneEntityFixup<T>::remap(&component, 1, created, createdCount);
+                pool.insertData(created[owners[i]], component);
+            }
+        };
+        types.push_back(type);
+    }
+
+    const SceneComponentType* find(const char* name) const {
+        for (const SceneComponentType& type : types) {
+            if (type.name == name) return &type;
+        }
+        return nullptr;
+    }
+
+    const std::vector<SceneComponentType>& componentTypes() const {
+        return types;
+    }
+};
+
+// Every component in Components.h. Animation clip handles are stored as-is,
+// so they assume clips are registered in the same order at load time.
+SceneRegistry defaultSceneRegistry() {
+    SceneRegistry registry;
+    registry.registerComponent<Transform>("Transform");
+    registry.registerComponent<PreviousTransform>("PreviousTransform");
+    registry.registerComponent<Sprite>("Sprite");
+    registry.registerComponent<Velocity>("Velocity");
+    registry.registerComponent<Collider>("Collider");
+    registry.registerComponent<RigidBody>("RigidBody");
+    registry.registerComponent<PlayerController>("PlayerController");
+    registry.registerComponent<Animation>("Animation");
+    registry.registerComponent<ParticleEmitter>("ParticleEmitter");
+    registry.registerComponent<Particle>("Particle");
+    registry.registerComponent<Health>("Health");
+    registry.registerComponent<Lifetime>("Lifetime");
+    registry.registerComponent<RenderLayer>("RenderLayer");
+    registry.registerComponent<Parent>("Parent");
+    registry.registerComponent<LocalTransform>("LocalTransform");
+    registry.registerComponent<NavAgent>("NavAgent");
+    return registry;
+}
+
+std::uint64_t alignSceneOffset(std::uint64_t offset) {
+    return (offset + SCENE_BLOCK_ALIGNMENT - 1) & ~(std::uint64_t)(SCENE_BLOCK_ALIGNMENT - 1);
+}
+
+// Writes every living entity and every non-empty registered pool. Sprite
+// textures missing from the table are written as "no texture".
+bool writeScene(ECS& ecs, const SceneRegistry& registry, const SceneTextures& textures,
+                const char* path, std::string& error) {
+    if (!hostIsLittleEndian()) {
+        error = "scene files are little-endian and this host is not";
+        return false;
+    }
+
+    std::vector<Entity> living;
+    living.reserve(ecs.entities().livingCount());
+    for (Entity entity = 0; entity < ecs.entities().entityCapacityUsed(); ++entity) {
+        if (ecs.entities().isAlive(entity)) living.push_back(entity);
+    }
+
+    struct PoolData {
+        const SceneComponentType* type;
+        std::vector<std::uint8_t> components;
+        std::vector<Entity> entities;
+    };
+    std::vector<PoolData> pools;
+    for (const SceneComponentType& type : registry.componentTypes()) {
+        if (!type.hasPool(ecs)) continue;
+        PoolData pool{&type, {}, {}};
+        type.save(ecs, textures, pool.components, pool.entities);
+        if (!pool.entities.empty()) pools.push_back(std::move(pool));
+    }
+
+    SceneFileHeader header{};
+    std::memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_FILE_VERSION;
+    header.byteOrder = SCENE_BYTE_ORDER_MARK;
+    header.entityCapacity = living.empty() ? 0 : living.back() + 1;
+    header.livingCount = (std::uint32_t)living.size();
+    header.poolCount = (std::uint32_t)pools.size();
+    header.textureCount = (std::uint32_t)textures.paths.size();
+
+    std::uint64_t offset = sizeof(SceneFileHeader);
+    header.livingOffset = offset = alignSceneOffset(offset);
+    offset += living.size() * sizeof(Entity);
+    header.poolTableOffset = offset = alignSceneOffset(offset);
+    offset += pools.size() * sizeof(ScenePoolEntry);
+    header.textureTableOffset = offset = alignSceneOffset(offset);
+    for (const std::string& texturePath : textures.paths) {
+        offset += sizeof(std::uint32_t) + texturePath.size();
+    }
+
+    std::vector<ScenePoolEntry> entries(pools.size());
+    for (size_t i = 0; i < pools.size(); ++i) {
+        ScenePoolEntry& entry = entries[i];
+        std::strncpy(entry.name, pools[i].type->name.c_str(), SCENE_COMPONENT_NAME_LENGTH - 1);
+        entry.componentSize = pools[i].type->size;
+        entry.count = (std::uint32_t)pools[i].entities.size();
+        entry.componentsOffset = offset = alignSceneOffset(offset);
+        offset += pools[i].components.size();
+        entry.entitiesOffset = offset = alignSceneOffset(offset);
+        offset += pools[i].entities.size() * sizeof(Entity);
+    }
+    header.fileSize = offset;
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        error = std::string("could not open ") + path + " for writing";
+        return false;
+    }
+
+    std::uint64_t written = 0;
+    auto write = [&](const void* data, size_t size) {
+        if (size > 0) fwrite(data, 1, size, file);
+        written += size;
+    };
+    auto padTo = [&](std::uint64_t target) {
+        static const std::uint8_t zeros[SCENE_BLOCK_ALIGNMENT] = {};
+        write(zeros, (size_t)(target - written));
+    };
+
+    write(&header, sizeof(header));
+    padTo(header.livingOffset);
+    write(living.data(), living.size() * sizeof(Entity));
+    padTo(header.poolTableOffset);
+    write(entries.data(), entries.size() * sizeof(ScenePoolEntry));
+    padTo(header.textureTableOffset);
+    for (const std::string& texturePath : textures.paths) {
+        std::uint32_t length = (std::uint32_t)texturePath.size();
+        write(&length, sizeof(length));
+        write(texturePath.data(), texturePath.size());
+    }
+    for (size_t i = 0; i < pools.size(); ++i) {
+        padTo(entries[i].componentsOffset);
+        write(pools[i].components.data(), pools[i].components.size());
+        padTo(entries[i].entitiesOffset);
+        write(pools[i].entities.data(), pools[i].entities.size() * sizeof(Entity));
+    }
+
+    bool failed = ferror(file) != 0;
+    if (fclose(file) != 0 || failed) {
+        error = std::string("failed writing ") + path;
+        return false;
+    }
+    return true;
+}
+
+bool sceneRangeValid(const SceneFileHeader& header, std::uint64_t offset, std::uint64_t size) {
+    return offset <= header.fileSize && size <= header.fileSize - offset;
+}
+
+bool sceneEntitiesValid(const Entity* entities, size_t count, std::uint32_t entityCapacity) {
+    for (size_t i = 0; i < count; ++i) {
+        if (entities[i] >= entityCapacity) return false;
+    }
+    return true;
+}
+
+// Loads a scene into a freshly constructed ECS. The file is mapped rather
+// than read, and each pool is bulk-copied straight out of the mapping.
+// Textures are resolved by path through the given table; paths it does not
+// contain load as "no texture". Pools with names the registry does not know
+// are skipped. Nothing in the ECS is touched unless the whole file validates.
+bool loadScene(ECS& ecs, const SceneRegistry& registry, const SceneTextures& textures,
+               const char* path, std::string& error) {
+    if (ecs.entities().livingCount() != 0) {
+        error = "scenes can only be loaded into an empty ECS";
+        return false;
+    }
+    if (!hostIsLittleEndian()) {
+        error = "scene files are little-endian and this host is not";
+        return false;
+    }
+
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        error = std::string("could not map ") + path;
+        return false;
+    }
+    if (file.size() < sizeof(SceneFileHeader)) {
+        error = "file is too small to be a scene";
+        return false;
+    }
+
+    const std::uint8_t* base = file.data();
+    SceneFileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a scene file";
+        return false;
+    }
+    if (header.version != SCENE_FILE_VERSION) {
+        error = "unsupported scene version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.byteOrder != SCENE_BYTE_ORDER_MARK) {
+        error = "scene file byte order does not match";
+        return false;
+    }
+    if (header.fileSize != file.size()) {
+        error = "scene file is truncated";
+        return false;
+    }
+    if (header.entityCapacity > ecs.entities().capacity() || header.livingCount > header.entityCapacity) {
+        error = "scene needs " + std::to_string(header.entityCapacity) + " entity slots, the world has " +
+                std::to_string(ecs.entities().capacity());
+        return false;
+    }
+    if (!sceneRangeValid(header, header.livingOffset, (std::uint64_t)header.livingCount * sizeof(Entity)) ||
+        !sceneRangeValid(header, header.poolTableOffset, (std::uint64_t)header.poolCount * sizeof(ScenePoolEntry)) ||
+        header.livingOffset % alignof(Entity) != 0 || header.poolTableOffset % alignof(ScenePoolEntry) != 0) {
+        error = "scene section table is corrupt";
+        return false;
+    }
+
+    const Entity* living = (const Entity*)(base + header.livingOffset);
+    if (!sceneEntitiesValid(living, header.livingCount, header.entityCapacity)) {
+        error = "scene entity list is corrupt";
+        return false;
+    }
+    // Per entity: 1 once living, then the number of the last pool that
+    // claimed it, so duplicates and dead owners are caught before loading.
+    std::vector<std::uint32_t> claimedBy(header.entityCapacity, 0);
+    for (std::uint32_t i = 0; i < header.livingCount; ++i) {
+        if (claimedBy[living[i]] != 0) {
+            error = "scene entity list is corrupt";
+            return false;
+        }
+        claimedBy[living[i]] = 1;
+    }
+
+    SceneTextures fileTextures;
+    std::uint64_t textureOffset = header.textureTableOffset;
+    for (std::uint32_t i = 0; i < header.textureCount; ++i) {
+        std::uint32_t length;
+        if (!sceneRangeValid(header, textureOffset, sizeof(length))) {
+            error = "scene texture table is corrupt";
+            return false;
+        }
+        std::memcpy(&length, base + textureOffset, sizeof(length));
+        textureOffset += sizeof(length);
+        if (!sceneRangeValid(header, textureOffset, length)) {
+            error = "scene texture table is corrupt";
+            return false;
+        }
+        std::string texturePath((const char*)(base + textureOffset), length);
+        textureOffset += length;
+        size_t match = textures.find(texturePath);
+        if (match < textures.paths.size()) {
+            fileTextures.add(texturePath, textures.textures[match], textures.assets[match]);
+        } else {
+            fileTextures.add(texturePath, nullptr);
+        }
+    }
+
+    struct PoolLoad {
+        const SceneComponentType* type;
+        const ScenePoolEntry* entry;
+    };
+    std::vector<PoolLoad> loads;
+    const ScenePoolEntry* entries = (const ScenePoolEntry*)(base + header.poolTableOffset);
+    for (std::uint32_t i = 0; i < header.poolCount; ++i) {
+        const ScenePoolEntry& entry = entries[i];
+        char name[SCENE_COMPONENT_NAME_LENGTH + 1] = {};
+        std::memcpy(name, entry.name, SCENE_COMPONENT_NAME_LENGTH);
+
+        const SceneComponentType* type = registry.find(name);
+        if (type == nullptr) continue;
+        if (entry.componentSize != type->size) {
+            error = std::string("component ") + name + " is " + std::to_string(entry.componentSize) +
+                    " bytes in the scene but " + std::to_string(type->size) + " in this build";
+            return false;
+        }
+
+        std::uint64_t componentBytes = (std::uint64_t)entry.count * entry.componentSize;
+        const Entity* poolEntities = (const Entity*)(base + entry.entitiesOffset);
+        if (entry.count > header.livingCount ||
+            !sceneRangeValid(header, entry.componentsOffset, componentBytes) ||
+            !sceneRangeValid(header, entry.entitiesOffset, (std::uint64_t)entry.count * sizeof(Entity)) ||
+            entry.componentsOffset % SCENE_BLOCK_ALIGNMENT != 0 || entry.entitiesOffset % alignof(Entity) != 0 ||
+            !sceneEntitiesValid(poolEntities, entry.count, header.entityCapacity)) {
+            error = std::string("pool ") + name + " is corrupt";
+            return false;
+        }
+        std::uint32_t poolMark = i + 2;
+        for (std::uint32_t j = 0; j < entry.count; ++j) {
+            std::uint32_t& claim = claimedBy[poolEntities[j]];
+            if (claim == 0 || claim == poolMark) {
+                error = std::string("pool ") + name + (claim == 0 ? " has an owner that is not alive"
+                                                                  : " has a duplicate owner");
+                return false;
+            }
+            claim = poolMark;
+        }
+        loads.push_back(PoolLoad{type, &entry});
+    }
+
+    ecs.entities().assignLiving(living, header.livingCount);
+    for (const PoolLoad& load : loads) {
+        load.type->load(ecs, base + load.entry->componentsOffset,
+                        (const Entity*)(base + load.entry->entitiesOffset), load.entry->count, fileTextures);
+    }
+    return true;
+}
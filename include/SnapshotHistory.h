@@ -0,0 +1,280 @@
+#pragma once
+#include "ECS.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Changed-chunk encoding of one buffer against the same buffer one frame
+// earlier: only the CHUNK_SIZE-byte chunks that differ are kept. Anything past
+// the end of the older buffer counts as changed.
+struct ByteDelta {
+    static constexpr size_t CHUNK_SIZE = 32;
+
+    std::uint32_t size = 0;
+    std::vector<std::uint32_t> chunks;
+    std::vector<std::uint8_t> bytes;
+
+    void encode(const std::uint8_t* previous, size_t previousSize, const std::uint8_t* current, size_t currentSize) {
+        size = (std::uint32_t)currentSize;
+        chunks.clear();
+        bytes.clear();
+        for (size_t offset = 0; offset < currentSize; offset += CHUNK_SIZE) {
+            size_t length = std::min(CHUNK_SIZE, currentSize - offset);
+            if (offset + length <= previousSize && std::memcmp(previous + offset, current + offset, length) == 0) {
+                continue;
+            }
+            chunks.push_back((std::uint32_t)(offset / CHUNK_SIZE));
+            bytes.insert(bytes.end(), current + offset, current + offset + length);
+        }
+    }
+
+    template<typename T>
+    void encode(const std::vector<T>& previous, const std::vector<T>& current) {
+        encode((const std::uint8_t*)previous.data(), previous.size() * sizeof(T),
+               (const std::uint8_t*)current.data(), current.size() * sizeof(T));
+    }
+
+    // Turns the previous frame's buffer into this frame's.
+    template<typename T>
+    void apply(std::vector<T>& buffer) const {
+        buffer.resize(size / sizeof(T));
+        std::uint8_t* target = (std::uint8_t*)buffer.data();
+        const std::uint8_t* source = bytes.data();
+        for (std::uint32_t chunk : chunks) {
+            size_t offset = (size_t)chunk * CHUNK_SIZE;
+            size_t length = std::min(CHUNK_SIZE, (size_t)size - offset);
+            std::memcpy(target + offset, source, length);
+            source += length;
+        }
+    }
+
+    size_t byteSize() const {
+        return chunks.size() * sizeof(std::uint32_t) + bytes.size();
+    }
+
+    size_t reservedBytes() const {
+        return chunks.capacity() * sizeof(std::uint32_t) + bytes.capacity();
+    }
+};
+
+// Ring of recent world states for rollback and replay. Every KEYFRAME_INTERVAL
+// frames a full WorldSnapshot is kept; the frames between store only the
+// chunks that changed since the frame before, so a second of history costs a
+// few full copies plus whatever actually moved. Restoring a frame decodes
+// forward from its keyframe. When the oldest keyframe falls out of the ring,
+// the frame after it is decoded and promoted to a keyframe.
+class SnapshotHistory {
+public:
+    static constexpr size_t KEYFRAME_INTERVAL = 16;
+
+private:
+    struct PoolDelta {
+        std::type_index type = std::type_index(typeid(void));
+        std::shared_ptr<ComponentArray> (*create)(Entity capacity) = nullptr;
+        std::uint32_t count = 0;
+        ByteDelta components;
+        ByteDelta entities;
+    };
+
+    struct Frame {
+        std::uint64_t tick = 0;
+        bool keyframe = false;
+        WorldSnapshot full;
+        std::vector<PoolDelta> pools;
+        ByteDelta recycledEntities;
+        ByteDelta alive;
+        Entity nextFreshEntity = 0;
+        std::uint32_t livingCount = 0;
+    };
+
+    std::vector<Frame> frames;
+    size_t oldest = 0;
+    size_t count = 0;
+    size_t sinceKeyframe = 0;
+    WorldSnapshot previous;
+    WorldSnapshot current;
+    WorldSnapshot decoded;
+
+    Frame& at(size_t age) {
+        return frames[(oldest + age) % frames.size()];
+    }
+
+    static const PoolSnapshot* findPool(const WorldSnapshot& snapshot, std::type_index type, size_t hint) {
+        if (hint < snapshot.pools.size() && snapshot.pools[hint].type == type) return &snapshot.pools[hint];
+        for (const PoolSnapshot& pool : snapshot.pools) {
+            if (pool.type == type) return &pool;
+        }
+        return nullptr;
+    }
+
+    static void encodeDelta(const WorldSnapshot& before, const WorldSnapshot& after, Frame& frame) {
+        frame.pools.resize(after.pools.size());
+        for (size_t i = 0; i < after.pools.size(); ++i) {
+            const PoolSnapshot& pool = after.pools[i];
+            const PoolSnapshot* base = findPool(before, pool.type, i);
+            PoolDelta& delta = frame.pools[i];
+            delta.type = pool.type;
+            delta.create = pool.create;
+            delta.count = pool.count;
+            if (base != nullptr) {
+                delta.components.encode(base->components, pool.components);
+                delta.entities.encode(base->entities, pool.entities);
+            } else {
+                delta.components.encode(nullptr, 0, pool.components.data(), pool.components.size());
+                delta.entities.encode(nullptr, 0, (const std::uint8_t*)pool.entities.data(),
+                                      pool.entities.size() * sizeof(Entity));
+            }
+        }
+        frame.recycledEntities.encode(before.recycledEntities, after.recycledEntities);
+        frame.alive.encode(before.alive, after.alive);
+        frame.nextFreshEntity = after.nextFreshEntity;
+        frame.livingCount = after.livingCount;
+    }
+
+    static void releaseDelta(Frame& frame) {
+        frame.pools = std::vector<PoolDelta>();
+        frame.recycledEntities = ByteDelta();
+        frame.alive = ByteDelta();
+    }
+
+    // Advances snapshot (the state of the frame before) to this frame.
+    static void applyDelta(const Frame& frame, WorldSnapshot& snapshot) {
+        std::vector<PoolSnapshot>& pools = snapshot.pools;
+        for (size_t i = 0; i < frame.pools.size(); ++i) {
+            const PoolDelta& delta = frame.pools[i];
+            size_t match = i;
+            while (match < pools.size() && pools[match].type != delta.type) ++match;
+            if (match == pools.size()) {
+                match = std::min(i, pools.size());
+                pools.insert(pools.begin() + match, PoolSnapshot());
+            }
+            std::swap(pools[i], pools[match]);
+            PoolSnapshot& pool = pools[i];
+            pool.type = delta.type;
+            pool.create = delta.create;
+            pool.count = delta.count;
+            delta.components.apply(pool.components);
+            delta.entities.apply(pool.entities);
+        }
+        pools.resize(frame.pools.size());
+        frame.recycledEntities.apply(snapshot.recycledEntities);
+        frame.alive.apply(snapshot.alive);
+        snapshot.nextFreshEntity = frame.nextFreshEntity;
+        snapshot.livingCount = frame.livingCount;
+    }
+
+public:
+    explicit SnapshotHistory(size_t capacity = 120) : frames(std::max<size_t>(2, capacity)) {}
+
+    void push(const ECS& ecs, std::uint64_t tick) {
+        ecs.snapshot(current);
+
+        if (count == frames.size()) {
+            Frame& evicted = at(0);
+            oldest = (oldest + 1) % frames.size();
+            --count;
+            Frame& next = at(0);
+            if (evicted.keyframe && !next.keyframe && count > 0) {
+                std::swap(next.full, evicted.full);
+                applyDelta(next, next.full);
+                next.keyframe = true;
+                releaseDelta(next);
+            }
+            evicted.full = WorldSnapshot();
+        }
+
+        Frame& frame = frames[(oldest + count) % frames.size()];
+        frame.tick = tick;
+        if (count == 0 || sinceKeyframe + 1 >= KEYFRAME_INTERVAL) {
+            frame.keyframe = true;
+            frame.full = current;
+            releaseDelta(frame);
+            sinceKeyframe = 0;
+        } else {
+            // The slot may have held a keyframe on an earlier lap.
+            frame.keyframe = false;
+            frame.full = WorldSnapshot();
+            encodeDelta(previous, current, frame);
+            ++sinceKeyframe;
+        }
+        ++count;
+        std::swap(previous, current);
+    }
+
+    // Restores the newest frame at or before tick. Returns false if the
+    // history does not reach back that far.
+    bool restore(ECS& ecs, std::uint64_t tick) {
+        size_t target = count;
+        for (size_t age = count; age-- > 0;) {
+            if (at(age).tick <= tick) {
+                target = age;
+                break;
+            }
+        }
+        if (target == count) return false;
+
+        size_t keyframe = target;
+        while (!at(keyframe).keyframe) --keyframe;
+
+        decoded = at(keyframe).full;
+        for (size_t age = keyframe + 1; age <= target; ++age) {
+            applyDelta(at(age), decoded);
+        }
+        ecs.restore(decoded);
+
+        // Later frames describe a future that no longer happened.
+        count = target + 1;
+        previous = decoded;
+        sinceKeyframe = target - keyframe;
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return frames.size();
+    }
+
+    std::uint64_t oldestTick() const {
+        return count > 0 ? frames[oldest].tick : 0;
+    }
+
+    std::uint64_t newestTick() const {
+        return count > 0 ? frames[(oldest + count - 1) % frames.size()].tick : 0;
+    }
+
+    // Encoded size of the stored frames, not counting spare capacity.
+    size_t storedBytes() const {
+        size_t total = 0;
+        for (size_t age = 0; age < count; ++age) {
+            const Frame& frame = frames[(oldest + age) % frames.size()];
+            if (frame.keyframe) {
+                total += frame.full.byteSize();
+                continue;
+            }
+            for (const PoolDelta& pool : frame.pools) {
+                total += pool.components.byteSize() + pool.entities.byteSize();
+            }
+            total += frame.recycledEntities.byteSize() + frame.alive.byteSize();
+        }
+        return total;
+    }
+
+    // Heap actually held: every slot's buffers with their spare capacity,
+    // plus the scratch snapshots used for encoding and decoding.
+    size_t retainedBytes() const {
+        size_t total = frames.capacity() * sizeof(Frame) + previous.reservedBytes() + current.reservedBytes() +
+                       decoded.reservedBytes();
+        for (const Frame& frame : frames) {
+            total += frame.full.reservedBytes() + frame.pools.capacity() * sizeof(PoolDelta) +
+                     frame.recycledEntities.reservedBytes() + frame.alive.reservedBytes();
+            for (const PoolDelta& pool : frame.pools) {
+                total += pool.components.reservedBytes() + pool.entities.reservedBytes();
+            }
+        }
+        return total;
+    }
+};
@@ -0,0 +1,332 @@
+#pragma once
+#include "RenderBackend.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAME_ENGINE_SSE2 1
+#endif
+
+// Pixels are stored as SDL_PIXELFORMAT_RGBA32: bytes R, G, B, A in memory.
+struct SoftwareTexture {
+    int width = 0;
+    int height = 0;
+    bool blend = true;
+    std::vector<std::uint32_t> pixels;
+};
+
+enum class TextureFilter {
+    Nearest,
+    Bilinear
+};
+
+std::uint32_t packRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    std::uint8_t bytes[4] = {r, g, b, a};
+    std::uint32_t pixel;
+    std::memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+// Source-over with the same result SDL_BLENDMODE_BLEND gives:
+//   dstRGB = srcRGB * srcA + dstRGB * (1 - srcA)
+//   dstA   = srcA + dstA * (1 - srcA)
+std::uint32_t blendPixel(std::uint32_t src, std::uint32_t dst) {
+    std::uint32_t alpha = src >> 24;
+    if (alpha == 255) return src;
+    if (alpha == 0) return dst;
+
+    std::uint32_t inverse = 255 - alpha;
+    std::uint32_t result = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+        std::uint32_t value = ((src >> shift) & 0xFF) * alpha + ((dst >> shift) & 0xFF) * inverse + 128;
+        result |= ((value + (value >> 8)) >> 8) << shift;
+    }
+    std::uint32_t value = 255 * alpha + (dst >> 24) * inverse + 128;
+    result |= ((value + (value >> 8)) >> 8) << 24;
+    return result;
+}
+
+void blendSpan(const std::uint32_t* src, std::uint32_t* dst, int count) {
+    int i = 0;
+#ifdef GAME_ENGINE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(128);
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i source = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i dest = _mm_loadu_si128((const __m128i*)(dst + i));
+
+        __m128i result[2];
+        for (int half = 0; half < 2; ++half) {
+            __m128i s = half == 0 ? _mm_unpacklo_epi8(source, zero) : _mm_unpackhi_epi8(source, zero);
+            __m128i d = half == 0 ? _mm_unpacklo_epi8(dest, zero) : _mm_unpackhi_epi8(dest, zero);
+
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+            __m128i inverse = _mm_sub_epi16(full, alpha);
+            s = _mm_or_si128(_mm_andnot_si128(alphaLanes, s), _mm_and_si128(alphaLanes, full));
+
+            __m128i value = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, alpha), _mm_mullo_epi16(d, inverse)), rounding);
+            result[half] = _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+        }
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(result[0], result[1]));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(src[i], dst[i]);
+    }
+}
+
+std::uint32_t lerpPixel(std::uint32_t a, std::uint32_t b, std::uint32_t weight) {
+    std::uint32_t inverse = 256 - weight;
+    std::uint32_t rb = (((a & 0x00FF00FFu) * inverse + (b & 0x00FF00FFu) * weight) >> 8) & 0x00FF00FFu;
+    std::uint32_t ga = (((a >> 8) & 0x00FF00FFu) * inverse + ((b >> 8) & 0x00FF00FFu) * weight) & 0xFF00FF00u;
+    return rb | ga;
+}
+
+// Rasterizes into an in-memory RGBA framebuffer. With a window it presents
+// through the window surface; without one it is fully headless.
+class SoftwareRenderBackend : public RenderBackend {
+private:
+    SoftwareTexture frame;
+    SoftwareTexture* target;
+    SDL_Window* window;
+    TextureFilter filter;
+    std::uint32_t drawColor = 0xFF000000u;
+    std::vector<std::uint32_t> rowBuffer;
+
+    static bool clipRect(const SDL_Rect& rect, int width, int height, SDL_Rect& clipped) {
+        int x0 = std::max(rect.x, 0);
+        int y0 = std::max(rect.y, 0);
+        int x1 = std::min(rect.x + rect.w, width);
+        int y1 = std::min(rect.y + rect.h, height);
+        if (x0 >= x1 || y0 >= y1) return false;
+        clipped = SDL_Rect{x0, y0, x1 - x0, y1 - y0};
+        return true;
+    }
+
+    // u and v are 16.16 fixed-point texel coordinates of the sample centre.
+    std::uint32_t sample(const SoftwareTexture& texture, const SDL_Rect& src, std::int64_t u, std::int64_t v) const {
+        if (filter == TextureFilter::Nearest) {
+            int x = std::clamp((int)(u >> 16), 0, src.w - 1) + src.x;
+            int y = std::clamp((int)(v >> 16), 0, src.h - 1) + src.y;
+            return texture.pixels[(size_t)y * texture.width + x];
+        }
+
+        u -= 0x8000;
+        v -= 0x8000;
+        int x0 = std::clamp((int)(u >> 16), 0, src.w - 1);
+        int y0 = std::clamp((int)(v >> 16), 0, src.h - 1);
+        int x1 = std::min(x0 + 1, src.w - 1);
+        int y1 = std::min(y0 + 1, src.h - 1);
+        std::uint32_t fx = u < 0 ? 0 : (std::uint32_t)((u >> 8) & 0xFF);
+        std::uint32_t fy = v < 0 ? 0 : (std::uint32_t)((v >> 8) & 0xFF);
+
+        const std::uint32_t* row0 = &texture.pixels[(size_t)(y0 + src.y) * texture.width + src.x];
+        const std::uint32_t* row1 = &texture.pixels[(size_t)(y1 + src.y) * texture.width + src.x];
+        std::uint32_t top = lerpPixel(row0[x0], row0[x1], fx);
+        std::uint32_t bottom = lerpPixel(row1[x0], row1[x1], fx);
+        return lerpPixel(top, bottom, fy);
+    }
+
+    void drawAxisAligned(const SoftwareTexture& texture, const SDL_Rect& src, const SDL_Rect& dest) {
+        SDL_Rect clipped;
+        if (!clipRect(dest, target->width, target->height, clipped)) return;
+
+        std::int64_t stepU = ((std::int64_t)src.w << 16) / dest.w;
+        std::int64_t stepV = ((std::int64_t)src.h << 16) / dest.h;
+        rowBuffer.resize(clipped.w);
+
+        for (int y = clipped.y; y < clipped.y + clipped.h; ++y) {
+            std::int64_t v = (y - dest.y) * stepV + stepV / 2;
+            std::int64_t u = (clipped.x - dest.x) * stepU + stepU / 2;
+            for (int i = 0; i < clipped.w; ++i, u += stepU) {
+                rowBuffer[i] = sample(texture, src, u, v);
+            }
+
+            std::uint32_t* row = &target->pixels[(size_t)y * target->width + clipped.x];
+            if (texture.blend) {
+                blendSpan(rowBuffer.data(), row, clipped.w);
+            } else {
+                std::memcpy(row, rowBuffer.data(), clipped.w * sizeof(std::uint32_t));
+            }
+        }
+    }
+
+    // Inverse-maps every pixel of the rotated rect's bounding box back into
+    // the source rect, rotating clockwise about the centre like SDL does.
+    void drawRotated(const SoftwareTexture& texture, const SDL_Rect& src, const SDL_Rect& dest, double rotation) {
+        double radians = rotation * 3.14159265358979323846 / 180.0;
+        double cosA = std::cos(radians);
+        double sinA = std::sin(radians);
+        double centerX = dest.x + dest.w * 0.5;
+        double centerY = dest.y + dest.h * 0.5;
+        double extentX = std::abs(dest.w * 0.5 * cosA) + std::abs(dest.h * 0.5 * sinA);
+        double extentY = std::abs(dest.w * 0.5 * sinA) + std::abs(dest.h * 0.5 * cosA);
+
+        SDL_Rect bounds = {
+            (int)std::floor(centerX - extentX),
+            (int)std::floor(centerY - extentY),
+            (int)std::ceil(extentX * 2) + 1,
+            (int)std::ceil(extentY * 2) + 1
+        };
+        SDL_Rect clipped;
+        if (!clipRect(bounds, target->width, target->height, clipped)) return;
+
+        double scaleU = (double)src.w / dest.w;
+        double scaleV = (double)src.h / dest.h;
+
+        for (int y = clipped.y; y < clipped.y + clipped.h; ++y) {
+            std::uint32_t* row = &target->pixels[(size_t)y * target->width];
+            for (int x = clipped.x; x < clipped.x + clipped.w; ++x) {
+                double dx = x + 0.5 - centerX;
+                double dy = y + 0.5 - centerY;
+                double localX = dx * cosA + dy * sinA + dest.w * 0.5;
+                double localY = -dx * sinA + dy * cosA + dest.h * 0.5;
+                if (localX < 0 || localY < 0 || localX >= dest.w || localY >= dest.h) continue;
+
+                std::uint32_t texel = sample(texture, src,
+                                             (std::int64_t)(localX * scaleU * 65536.0),
+                                             (std::int64_t)(localY * scaleV * 65536.0));
+                row[x] = texture.blend ? blendPixel(texel, row[x]) : texel;
+            }
+        }
+    }
+
+public:
+    SoftwareRenderBackend(int width, int height, SDL_Window* window = nullptr,
+                          TextureFilter filter = TextureFilter::Nearest)
+        : target(&frame), window(window), filter(filter) {
+        frame.width = width;
+        frame.height = height;
+        frame.blend = false;
+        frame.pixels.assign((size_t)width * height, 0xFF000000u);
+        textureMemory = frame.pixels.size() * sizeof(std::uint32_t);
+    }
+
+    const SoftwareTexture& framebuffer() const {
+        return frame;
+    }
+
+    void setFilter(TextureFilter textureFilter) {
+        filter = textureFilter;
+    }
+
+    void* createTexture(SDL_Surface* surface) override {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        if (converted == nullptr) return nullptr;
+
+        SoftwareTexture* texture = new SoftwareTexture();
+        texture->width = converted->w;
+        texture->height = converted->h;
+        texture->pixels.resize((size_t)converted->w * converted->h);
+
+        SDL_LockSurface(converted);
+        for (int y = 0; y < converted->h; ++y) {
+            std::memcpy(&texture->pixels[(size_t)y * converted->w],
+                        (const Uint8*)converted->pixels + (size_t)y * converted->pitch,
+                        converted->w * sizeof(std::uint32_t));
+        }
+        SDL_UnlockSurface(converted);
+        SDL_FreeSurface(converted);
+        textureMemory += texture->pixels.size() * sizeof(std::uint32_t);
+        return texture;
+    }
+
+    void* createRenderTarget(int targetWidth, int targetHeight) override {
+        SoftwareTexture* texture = new SoftwareTexture();
+        texture->width = targetWidth;
+        texture->height = targetHeight;
+        texture->blend = false;
+        texture->pixels.assign((size_t)targetWidth * targetHeight, 0xFF000000u);
+        textureMemory += texture->pixels.size() * sizeof(std::uint32_t);
+        return texture;
+    }
+
+    void destroyTexture(void* texture) override {
+        SoftwareTexture* softwareTexture = (SoftwareTexture*)texture;
+        if (softwareTexture == nullptr) return;
+        if (target == softwareTexture) {
+            target = &frame;
+        }
+        textureMemory -= softwareTexture->pixels.size() * sizeof(std::uint32_t);
+        delete softwareTexture;
+    }
+
+    void setRenderTarget(void* renderTarget) override {
+        target = renderTarget != nullptr ? (SoftwareTexture*)renderTarget : &frame;
+    }
+
+    // Like SDL's default draw blend mode, rect fills and outlines overwrite.
+    void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) override {
+        drawColor = packRGBA(r, g, b, a);
+    }
+
+    void clear() override {
+        std::fill(target->pixels.begin(), target->pixels.end(), drawColor);
+    }
+
+    void fillRect(const SDL_Rect& rect) override {
+        SDL_Rect clipped;
+        if (!clipRect(rect, target->width, target->height, clipped)) return;
+
+        for (int y = clipped.y; y < clipped.y + clipped.h; ++y) {
+            std::uint32_t* row = &target->pixels[(size_t)y * target->width + clipped.x];
+            std::fill(row, row + clipped.w, drawColor);
+        }
+    }
+
+    void drawRect(const SDL_Rect& rect) override {
+        if (rect.w <= 0 || rect.h <= 0) return;
+        fillRect(SDL_Rect{rect.x, rect.y, rect.w, 1});
+        fillRect(SDL_Rect{rect.x, rect.y + rect.h - 1, rect.w, 1});
+        fillRect(SDL_Rect{rect.x, rect.y, 1, rect.h});
+        fillRect(SDL_Rect{rect.x + rect.w - 1, rect.y, 1, rect.h});
+    }
+
+    void drawTexture(void* texture, const SDL_Rect* srcRect, const SDL_Rect& destRect, double rotation) override {
+        if (texture == nullptr || destRect.w <= 0 || destRect.h <= 0) return;
+
+        const SoftwareTexture& source = *(const SoftwareTexture*)texture;
+        SDL_Rect src = srcRect != nullptr ? *srcRect : SDL_Rect{0, 0, source.width, source.height};
+        if (!clipRect(src, source.width, source.height, src)) return;
+
+        if (rotation == 0.0) {
+            drawAxisAligned(source, src, destRect);
+        } else {
+            drawRotated(source, src, destRect, rotation);
+        }
+    }
+
+    void present() override {
+        if (window == nullptr) return;
+
+        SDL_Surface* windowSurface = SDL_GetWindowSurface(window);
+        if (windowSurface == nullptr) return;
+
+        SDL_Surface* frameSurface = SDL_CreateRGBSurfaceWithFormatFrom(
+            frame.pixels.data(), frame.width, frame.height, 32, frame.width * 4, SDL_PIXELFORMAT_RGBA32);
+        if (frameSurface == nullptr) return;
+
+        SDL_BlitSurface(frameSurface, NULL, windowSurface, NULL);
+        SDL_FreeSurface(frameSurface);
+        SDL_UpdateWindowSurface(window);
+    }
+
+    bool saveFrame(const char* path) override {
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+            frame.pixels.data(), frame.width, frame.height, 32, frame.width * 4, SDL_PIXELFORMAT_RGBA32);
+        if (surface == nullptr) return false;
+        bool saved = IMG_SavePNG(surface, path) == 0;
+        SDL_FreeSurface(surface);
+        return saved;
+    }
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include "RenderSnapshot.h"
+#include "RenderBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct StaticChunk {
+    void* texture = nullptr;
+    bool dirty = true;
+};
+
+// Draws the background grid and static platforms once into chunk-sized render
+// targets, then composites only the chunks the camera overlaps. A chunk is
+// redrawn only when a static rect touching it is added, moved or removed.
+class StaticLayerCache {
+private:
+    static constexpr int CHUNK_SIZE = 512;
+
+    RenderBackend& backend;
+    int worldWidth;
+    int worldHeight;
+    int gridSpacing;
+    std::unordered_map<std::uint64_t, StaticChunk> chunks;
+    std::vector<RectDraw> cachedRects;
+
+    static std::uint64_t chunkKey(int chunkX, int chunkY) {
+        return ((std::uint64_t)(std::uint32_t)chunkX << 32) | (std::uint32_t)chunkY;
+    }
+
+    static int chunkCoord(float worldCoord) {
+        return (int)std::floor(worldCoord / CHUNK_SIZE);
+    }
+
+    static bool sameRect(const RectDraw& a, const RectDraw& b) {
+        return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+    }
+
+    void invalidateRect(const RectDraw& rect) {
+        int minX = chunkCoord(rect.x);
+        int minY = chunkCoord(rect.y);
+        int maxX = chunkCoord(rect.x + rect.width);
+        int maxY = chunkCoord(rect.y + rect.height);
+
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cx = minX; cx <= maxX; ++cx) {
+                auto it = chunks.find(chunkKey(cx, cy));
+                if (it != chunks.end()) {
+                    it->second.dirty = true;
+                }
+            }
+        }
+    }
+
+    void redrawChunk(StaticChunk& chunk, int chunkX, int chunkY) {
+        if (chunk.texture == nullptr) {
+            chunk.texture = backend.createRenderTarget(CHUNK_SIZE, CHUNK_SIZE);
+            if (chunk.texture == nullptr) return;
+        }
+
+        int originX = chunkX * CHUNK_SIZE;
+        int originY = chunkY * CHUNK_SIZE;
+
+        backend.setRenderTarget(chunk.texture);
+
+        backend.setDrawColor(30, 30, 46, 255);
+        backend.clear();
+
+        backend.setDrawColor(80, 80, 100, 255);
+        int firstX = std::max(0, (originX / gridSpacing) * gridSpacing);
+        for (int x = firstX; x < worldWidth && x < originX + CHUNK_SIZE; x += gridSpacing) {
+            SDL_Rect line = {x - originX, 0, 2, CHUNK_SIZE};
+            backend.fillRect(line);
+        }
+        int firstY = std::max(0, (originY / gridSpacing) * gridSpacing);
+        for (int y = firstY; y < worldHeight && y < originY + CHUNK_SIZE; y += gridSpacing) {
+            SDL_Rect line = {0, y - originY, CHUNK_SIZE, 2};
+            backend.fillRect(line);
+        }
+
+        backend.setDrawColor(100, 100, 120, 255);
+        for (const RectDraw& rect : cachedRects) {
+            if (rect.x >= originX + CHUNK_SIZE || rect.x + rect.width <= originX ||
+                rect.y >= originY + CHUNK_SIZE || rect.y + rect.height <= originY) {
+                continue;
+            }
+            SDL_Rect local = {(int)rect.x - originX, (int)rect.y - originY, (int)rect.width, (int)rect.height};
+            backend.fillRect(local);
+        }
+
+        backend.setRenderTarget(nullptr);
+        chunk.dirty = false;
+    }
+
+public:
+    StaticLayerCache(RenderBackend& backend, int worldWidth, int worldHeight, int gridSpacing)
+        : backend(backend), worldWidth(worldWidth), worldHeight(worldHeight), gridSpacing(gridSpacing) {}
+
+    ~StaticLayerCache() {
+        release();
+    }
+
+    StaticLayerCache(const StaticLayerCache&) = delete;
+    StaticLayerCache& operator=(const StaticLayerCache&) = delete;
+
+    // Diffs the published static rects against the cached copy and marks only
+    // the chunks under changed rects dirty.
+    void sync(const std::vector<RectDraw>& staticRects) {
+        size_t common = std::min(staticRects.size(), cachedRects.size());
+        bool changed = staticRects.size() != cachedRects.size();
+
+        for (size_t i = 0; i < common; ++i) {
+            if (!sameRect(staticRects[i], cachedRects[i])) {
+                invalidateRect(cachedRects[i]);
+                invalidateRect(staticRects[i]);
+                changed = true;
+            }
+        }
+        for (size_t i = common; i < cachedRects.size(); ++i) {
+            invalidateRect(cachedRects[i]);
+        }
+        for (size_t i = common; i < staticRects.size(); ++i) {
+            invalidateRect(staticRects[i]);
+        }
+
+        if (changed) {
+            cachedRects = staticRects;
+        }
+    }
+
+    // Must run before the renderer that owns the chunk textures is destroyed.
+    void release() {
+        for (auto& pair : chunks) {
+            if (pair.second.texture != nullptr) {
+                backend.destroyTexture(pair.second.texture);
+            }
+        }
+        chunks.clear();
+    }
+
+    // Render targets are lost when the device is reset.
+    void invalidateAll() {
+        for (auto& pair : chunks) {
+            pair.second.dirty = true;
+        }
+    }
+
+    void render(float cameraX, float cameraY, int viewWidth, int viewHeight) {
+        int minX = chunkCoord(cameraX);
+        int minY = chunkCoord(cameraY);
+        int maxX = chunkCoord(cameraX + viewWidth - 1);
+        int maxY = chunkCoord(cameraY + viewHeight - 1);
+
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cx = minX; cx <= maxX; ++cx) {
+                StaticChunk& chunk = chunks[chunkKey(cx, cy)];
+                if (chunk.dirty) {
+                    redrawChunk(chunk, cx, cy);
+                }
+                if (chunk.texture == nullptr) continue;
+
+                SDL_Rect destRect = {
+                    cx * CHUNK_SIZE - (int)cameraX,
+                    cy * CHUNK_SIZE - (int)cameraY,
+                    CHUNK_SIZE,
+                    CHUNK_SIZE
+                };
+                backend.drawTexture(chunk.texture, NULL, destRect, 0.0);
+            }
+        }
+    }
+};
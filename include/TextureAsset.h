@@ -0,0 +1,19 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum class AssetState : std::uint8_t {
+    Pending,
+    Ready,
+    Failed
+};
+
+// Stable handle to a texture loaded by AssetLoader. texture holds the
+// loader's placeholder until the upload finishes and is swapped on the main
+// thread, so other threads can keep reading it while the load is in flight.
+struct TextureAsset {
+    std::string path;
+    std::atomic<void*> texture{nullptr};
+    std::atomic<AssetState> state{AssetState::Pending};
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from one FIFO queue. Tasks must
+// not block on other tasks in the same pool.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allIdle;
+    size_t activeTasks = 0;
+    bool stopping = false;
+
+    void workerLoop() {
+        PROFILE_THREAD("Worker");
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                ++activeTasks;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --activeTasks;
+                if (activeTasks == 0 && tasks.empty()) allIdle.notify_all();
+            }
+        }
+    }
+
+public:
+    // One thread per core, minus the one the caller is running on.
+    static size_t defaultThreadCount() {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 1;
+    }
+
+    explicit ThreadPool(size_t threadCount = defaultThreadCount()) {
+        threadCount = std::max<size_t>(1, threadCount);
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    // Queued tasks still run before the workers exit.
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskAvailable.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        taskAvailable.notify_one();
+    }
+
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        allIdle.wait(lock, [this] { return activeTasks == 0 && tasks.empty(); });
+    }
+
+    // Calls body(index, slot) for every index in [0, count), spread over the
+    // caller and up to threadCount() workers, and returns once all have run.
+    // slot is 0 on the caller and at most threadCount() on a worker, and no
+    // two bodies run on the same slot at once, so it can pick per-thread
+    // scratch. The caller claims indices too and does not wait on the queue,
+    // so this is safe while other tasks are queued, or from inside a task.
+    template<typename Body>
+    void parallelFor(size_t count, Body&& body) {
+        struct Batch {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> finished{0};
+            std::atomic<size_t> helpers{0};
+        };
+        if (count == 0) return;
+
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+        auto* work = &body;
+        auto run = [batch, work, count](size_t slot) {
+            for (size_t index = batch->next.fetch_add(1); index < count; index = batch->next.fetch_add(1)) {
+                (*work)(index, slot);
+                batch->finished.fetch_add(1, std::memory_order_release);
+            }
+        };
+
+        size_t helperCount = std::min(workers.size(), count - 1);
+        for (size_t i = 0; i < helperCount; ++i) {
+            // A helper that starts after the work is gone claims nothing and
+            // never touches body, which may be out of scope by then.
+            submit([batch, run] { run(batch->helpers.fetch_add(1) + 1); });
+        }
+        run(0);
+        while (batch->finished.load(std::memory_order_acquire) != count) {
+            std::this_thread::yield();
+        }
+    }
+
+    size_t threadCount() const {
+        return workers.size();
+    }
+};
@@ -0,0 +1,242 @@
+#pragma once
+#include "ECS.h"
+#include "Components.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Attaches child to parent at the given offset. The child's Transform becomes
+// its world transform and is owned by the hierarchy from the next update on;
+// move it through its LocalTransform instead. Re-attaching moves it to the
+// new parent.
+void attachToParent(ECS& ecs, Entity child, Entity parent, LocalTransform local) {
+    if (ecs.hasComponent<Parent>(child)) {
+        ecs.getComponent<Parent>(child).entity = parent;
+        ecs.getComponent<LocalTransform>(child) = local;
+        return;
+    }
+    ecs.addComponent(child, Parent{parent});
+    ecs.addComponent(child, local);
+}
+
+void detachFromParent(ECS& ecs, Entity child) {
+    ecs.removeComponent<Parent>(child);
+    ecs.removeComponent<LocalTransform>(child);
+}
+
+Transform composeTransform(const Transform& parent, const LocalTransform& local) {
+    const float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+    float x = local.x * parent.scaleX;
+    float y = local.y * parent.scaleY;
+    if (parent.rotation != 0.0f) {
+        float radians = parent.rotation * DEGREES_TO_RADIANS;
+        float c = std::cos(radians);
+        float s = std::sin(radians);
+        float rotatedX = x * c - y * s;
+        y = x * s + y * c;
+        x = rotatedX;
+    }
+    return Transform{
+        parent.x + x,
+        parent.y + y,
+        parent.rotation + local.rotation,
+        parent.scaleX * local.scaleX,
+        parent.scaleY * local.scaleY
+    };
+}
+
+// World transforms of attached entities, kept in a flat array sorted by depth
+// so every parent comes before its children and one linear pass updates them
+// all. Roots (parents that are not attached to anything) are moved by the
+// other systems; each update compares their Transform and every child's
+// LocalTransform against the cached copies, and only recomputes the subtrees
+// below something that changed. A still hierarchy costs one compare per node.
+//
+// The order is rebuilt when an attachment is added, removed or re-parented.
+// Children of a destroyed parent stay where they were last placed.
+class TransformHierarchy {
+private:
+    static constexpr std::int32_t NO_PARENT = -1;
+    static constexpr std::int32_t NOT_IN_HIERARCHY = -1;
+
+    struct Node {
+        Entity entity;
+        Entity parentEntity;
+        std::int32_t parent;
+        std::uint32_t depth;
+        LocalTransform local;
+        Transform world;
+        bool changed;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::int32_t> nodeIndex;
+    std::vector<std::uint32_t> depthOf;
+    std::vector<std::uint32_t> depthCounts;
+    std::vector<Node> sorted;
+    size_t attachedCount = 0;
+    bool needsRebuild = true;
+    bool recomputeAll = true;
+
+    static bool sameLocal(const LocalTransform& a, const LocalTransform& b) {
+        return a.x == b.x && a.y == b.y && a.rotation == b.rotation && a.scaleX == b.scaleX && a.scaleY == b.scaleY;
+    }
+
+    static bool sameWorld(const Transform& a, const Transform& b) {
+        return a.x == b.x && a.y == b.y && a.rotation == b.rotation && a.scaleX == b.scaleX && a.scaleY == b.scaleY;
+    }
+
+    // Depth below the nearest root; 0 for entities that are not attached or
+    // whose parent chain is broken or loops back on itself.
+    std::uint32_t depthFor(Entity entity, ComponentArrayImpl<Parent>& parents,
+                           ComponentArrayImpl<LocalTransform>& locals, ComponentArrayImpl<Transform>& transforms) {
+        if (depthOf[entity] != 0xFFFFFFFFu) return depthOf[entity];
+
+        // Marked in progress first, so a cycle terminates as a root.
+        depthOf[entity] = 0;
+        std::uint32_t depth = 0;
+        if (parents.hasData(entity) && locals.hasData(entity) && transforms.hasData(entity)) {
+            Entity parent = parents.getData(entity).entity;
+            if (parent < depthOf.size() && parent != entity && transforms.hasData(parent)) {
+                depth = depthFor(parent, parents, locals, transforms) + 1;
+            }
+        }
+        depthOf[entity] = depth;
+        return depth;
+    }
+
+    void rebuild(ECS& ecs) {
+        ComponentArrayImpl<Parent>& parents = ecs.pool<Parent>();
+        ComponentArrayImpl<LocalTransform>& locals = ecs.pool<LocalTransform>();
+        ComponentArrayImpl<Transform>& transforms = ecs.pool<Transform>();
+        const Entity* children = parents.entities();
+        size_t childCount = parents.count();
+
+        if (depthOf.size() != ecs.entities().capacity()) {
+            nodes.clear();
+            depthOf.assign(ecs.entities().capacity(), 0xFFFFFFFFu);
+            nodeIndex.assign(ecs.entities().capacity(), NOT_IN_HIERARCHY);
+        }
+        for (const Node& node : nodes) {
+            nodeIndex[node.entity] = NOT_IN_HIERARCHY;
+        }
+
+        // Children, plus each distinct root above them, bucketed by depth.
+        sorted.clear();
+        std::uint32_t maxDepth = 0;
+        for (size_t i = 0; i < childCount; ++i) {
+            Entity child = children[i];
+            std::uint32_t depth = depthFor(child, parents, locals, transforms);
+            if (depth == 0) continue;
+            Entity parent = parents.getData(child).entity;
+            sorted.push_back(Node{child, parent, NO_PARENT, depth, LocalTransform{}, Transform{}, true});
+            if (depthOf[parent] == 0 && nodeIndex[parent] == NOT_IN_HIERARCHY) {
+                nodeIndex[parent] = 0;
+                sorted.push_back(Node{parent, parent, NO_PARENT, 0, LocalTransform{}, Transform{}, true});
+            }
+            maxDepth = std::max(maxDepth, depth);
+        }
+
+        depthCounts.assign(maxDepth + 2, 0);
+        for (const Node& node : sorted) {
+            ++depthCounts[node.depth + 1];
+        }
+        for (std::uint32_t depth = 1; depth < depthCounts.size(); ++depth) {
+            depthCounts[depth] += depthCounts[depth - 1];
+        }
+        nodes.resize(sorted.size());
+        for (const Node& node : sorted) {
+            nodes[depthCounts[node.depth]++] = node;
+        }
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodeIndex[nodes[i].entity] = (std::int32_t)i;
+        }
+        for (Node& node : nodes) {
+            if (node.depth > 0) node.parent = nodeIndex[node.parentEntity];
+        }
+
+        for (size_t i = 0; i < childCount; ++i) {
+            depthOf[children[i]] = 0xFFFFFFFFu;
+        }
+        for (const Node& node : nodes) {
+            depthOf[node.entity] = 0xFFFFFFFFu;
+        }
+
+        attachedCount = childCount;
+        needsRebuild = false;
+        recomputeAll = true;
+    }
+
+    size_t pass(ECS& ecs) {
+        ComponentArrayImpl<Parent>& parents = ecs.pool<Parent>();
+        ComponentArrayImpl<LocalTransform>& locals = ecs.pool<LocalTransform>();
+        ComponentArrayImpl<Transform>& transforms = ecs.pool<Transform>();
+
+        size_t recomputed = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node& node = nodes[i];
+
+            if (!transforms.hasData(node.entity)) {
+                // Destroyed; the rebuild drops it along with its subtree.
+                needsRebuild = true;
+                node.changed = false;
+                continue;
+            }
+            Transform& transform = transforms.getData(node.entity);
+
+            if (node.parent == NO_PARENT) {
+                node.changed = recomputeAll || !sameWorld(transform, node.world);
+                if (node.changed) node.world = transform;
+                continue;
+            }
+
+            if (!parents.hasData(node.entity) || !locals.hasData(node.entity) ||
+                parents.getData(node.entity).entity != node.parentEntity) {
+                needsRebuild = true;
+                node.changed = false;
+                continue;
+            }
+
+            const LocalTransform& local = locals.getData(node.entity);
+            const Node& parent = nodes[node.parent];
+            node.changed = recomputeAll || parent.changed || !sameLocal(local, node.local);
+            if (!node.changed) continue;
+
+            node.local = local;
+            node.world = composeTransform(parent.world, local);
+            transform = node.world;
+            ++recomputed;
+        }
+        recomputeAll = false;
+        return recomputed;
+    }
+
+public:
+    // Forces a rebuild and a full recompute, e.g. after the ECS was restored
+    // from a snapshot or loaded from a scene file.
+    void invalidate() {
+        needsRebuild = true;
+    }
+
+    size_t nodeCount() const {
+        return nodes.size();
+    }
+
+    // Returns how many world transforms were recomputed. A structural change
+    // spotted mid-pass is rebuilt and finished in the same call.
+    size_t update(ECS& ecs) {
+        if (needsRebuild || ecs.pool<Parent>().count() != attachedCount) rebuild(ecs);
+        size_t recomputed = pass(ecs);
+        if (needsRebuild) {
+            rebuild(ecs);
+            recomputed += pass(ecs);
+        }
+        return recomputed;
+    }
+};
+
+void transformHierarchySystem(ECS& ecs, TransformHierarchy& hierarchy) {
+    hierarchy.update(ecs);
+}
@@ -0,0 +1,896 @@
+#pragma once
+#include "ECS.h"
+#include "Components.h"
+#include "SceneFile.h"
+#include "RenderSystem.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A streamed level is a directory:
+//
+//   level.gerl       RegionLevelHeader, one presence byte per region (row
+//                    major), then the texture path table as in scene files
+//   resident.gerc    chunk of entities that are never streamed out
+//   r_<x>_<y>.gerc   one chunk per non-empty region
+//
+// A chunk is a RegionChunkHeader followed, per pool, by a RegionChunkPool,
+// the packed components and their owners as indices into the chunk's own
+// entity list. Entity references (Parent) use the same numbering, so a chunk
+// can be instantiated into a live ECS under fresh IDs. Sprites store texture
+// table indices as in scene files, against the level's table.
+constexpr char REGION_LEVEL_MAGIC[4] = {'G', 'E', 'R', 'L'};
+constexpr char REGION_CHUNK_MAGIC[4] = {'G', 'E', 'R', 'C'};
+constexpr std::uint32_t REGION_FORMAT_VERSION = 1;
+
+struct RegionLevelHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t regionSize;
+    std::uint32_t regionsX;
+    std::uint32_t regionsY;
+    std::uint32_t worldWidth;
+    std::uint32_t worldHeight;
+    std::uint32_t textureCount;
+    std::uint32_t reserved[7];
+};
+
+struct RegionChunkHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entityCount;
+    std::uint32_t poolCount;
+};
+
+struct RegionChunkPool {
+    char name[SCENE_COMPONENT_NAME_LENGTH];
+    std::uint32_t componentSize;
+    std::uint32_t count;
+};
+
+static_assert(sizeof(RegionLevelHeader) == 64, "region level header layout changed");
+static_assert(sizeof(RegionChunkHeader) == 16, "region chunk header layout changed");
+static_assert(sizeof(RegionChunkPool) == 40, "region chunk pool layout changed");
+
+struct RegionLevel {
+    std::uint32_t regionSize = 0;
+    std::uint32_t regionsX = 0;
+    std::uint32_t regionsY = 0;
+    std::uint32_t worldWidth = 0;
+    std::uint32_t worldHeight = 0;
+    std::vector<std::uint8_t> present;
+    std::vector<std::string> texturePaths;
+
+    bool contains(int x, int y) const {
+        return x >= 0 && y >= 0 && (std::uint32_t)x < regionsX && (std::uint32_t)y < regionsY;
+    }
+
+    bool isPresent(int x, int y) const {
+        return contains(x, y) && present[(size_t)y * regionsX + x] != 0;
+    }
+};
+
+std::string regionChunkPath(const std::string& directory, int x, int y) {
+    return directory + "/r_" + std::to_string(x) + "_" + std::to_string(y) + ".gerc";
+}
+
+bool readRegionFile(const std::string& path, std::vector<std::uint8_t>& bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    bool ok = size >= 0;
+    if (ok) {
+        bytes.resize((size_t)size);
+        ok = size == 0 || fread(bytes.data(), 1, (size_t)size, file) == (size_t)size;
+    }
+    fclose(file);
+    return ok;
+}
+
+bool writeRegionFile(const std::string& path, const void* data, size_t size) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = size == 0 || fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+// Serializes the given entities as one chunk. localIndex is scratch space
+// holding INVALID_ENTITY for every ID on entry, and is left that way.
+void serializeRegionChunk(ECS& ecs, const SceneRegistry& registry, const SceneTextures& textures,
+                          const Entity* entities, size_t count, std::vector<Entity>& localIndex,
+                          std::vector<std::uint8_t>& out) {
+    if (localIndex.size() < ecs.entities().capacity()) localIndex.assign(ecs.entities().capacity(), INVALID_ENTITY);
+    for (size_t i = 0; i < count; ++i) {
+        localIndex[entities[i]] = (Entity)i;
+    }
+
+    RegionChunkHeader header{};
+    std::memcpy(header.magic, REGION_CHUNK_MAGIC, sizeof(header.magic));
+    header.version = REGION_FORMAT_VERSION;
+    header.entityCount = (std::uint32_t)count;
+
+    out.resize(sizeof(header));
+    std::vector<std::uint8_t> components;
+    std::vector<Entity> owners;
+    for (const SceneComponentType& type : registry.componentTypes()) {
+        type.saveEntities(ecs, entities, count, localIndex.data(), textures, components, owners);
+        if (owners.empty()) continue;
+
+        RegionChunkPool pool{};
+        std::strncpy(pool.name, type.name.c_str(), SCENE_COMPONENT_NAME_LENGTH - 1);
+        pool.componentSize = type.size;
+        pool.count = (std::uint32_t)owners.size();
+        const std::uint8_t* poolBytes = (const std::uint8_t*)&pool;
+        out.insert(out.end(), poolBytes, poolBytes + sizeof(pool));
+        out.insert(out.end(), components.begin(), components.end());
+        const std::uint8_t* ownerBytes = (const std::uint8_t*)owners.data();
+        out.insert(out.end(), ownerBytes, ownerBytes + owners.size() * sizeof(Entity));
+        ++header.poolCount;
+    }
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < count; ++i) {
+        localIndex[entities[i]] = INVALID_ENTITY;
+    }
+}
+
+// Creates a chunk's entities under fresh IDs, returned in created. Nothing
+// in the ECS is touched unless the whole chunk validates and fits.
+bool instantiateRegionChunk(ECS& ecs, const SceneRegistry& registry, const SceneTextures& textures,
+                            const std::uint8_t* data, size_t size, std::vector<Entity>& created,
+                            std::string& error) {
+    created.clear();
+    RegionChunkHeader header;
+    if (size < sizeof(header)) {
+        error = "region chunk is truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, REGION_CHUNK_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REGION_FORMAT_VERSION) {
+        error = "not a region chunk of version " + std::to_string(REGION_FORMAT_VERSION);
+        return false;
+    }
+    if (header.entityCount > ecs.entities().capacity() - ecs.entities().livingCount()) {
+        error = "region chunk needs " + std::to_string(header.entityCount) + " entities, " +
+                std::to_string(ecs.entities().capacity() - ecs.entities().livingCount()) + " are free";
+        return false;
+    }
+
+    struct PoolLoad {
+        const SceneComponentType* type;
+        size_t componentsOffset;
+        std::uint32_t count;
+    };
+    std::vector<PoolLoad> loads;
+    size_t offset = sizeof(header);
+    for (std::uint32_t i = 0; i < header.poolCount; ++i) {
+        RegionChunkPool pool;
+        if (size - offset < sizeof(pool)) {
+            error = "region chunk pool table is truncated";
+            return false;
+        }
+        std::memcpy(&pool, data + offset, sizeof(pool));
+        offset += sizeof(pool);
+
+        std::uint64_t poolBytes = (std::uint64_t)pool.count * (pool.componentSize + sizeof(Entity));
+        if (pool.count > header.entityCount || poolBytes > size - offset) {
+            error = "region chunk pool is corrupt";
+            return false;
+        }
+        char name[SCENE_COMPONENT_NAME_LENGTH + 1] = {};
+        std::memcpy(name, pool.name, SCENE_COMPONENT_NAME_LENGTH);
+        const SceneComponentType* type = registry.find(name);
+        if (type != nullptr && pool.componentSize != type->size) {
+            error = std::string("component ") + name + " is " + std::to_string(pool.componentSize) +
+                    " bytes in the chunk but " + std::to_string(type->size) + " in this build";
+            return false;
+        }
+
+        const std::uint8_t* owners = data + offset + (size_t)pool.count * pool.componentSize;
+        for (std::uint32_t j = 0; j < pool.count; ++j) {
+            Entity owner;
+            std::memcpy(&owner, owners + j * sizeof(Entity), sizeof(owner));
+            if (owner >= header.entityCount) {
+                error = std::string("pool ") + name + " has an owner outside the chunk";
+                return false;
+            }
+        }
+        if (type != nullptr) loads.push_back(PoolLoad{type, offset, pool.count});
+        offset += (size_t)poolBytes;
+    }
+
+    created.resize(header.entityCount);
+    for (Entity& entity : created) {
+        entity = ecs.createEntity();
+    }
+    std::vector<Entity> owners;
+    for (const PoolLoad& load : loads) {
+        const std::uint8_t* components = data + load.componentsOffset;
+        owners.resize(load.count);
+        if (load.count > 0) {
+            std::memcpy(owners.data(), components + (size_t)load.count * load.type->size, load.count * sizeof(Entity));
+        }
+        load.type->instantiate(ecs, components, owners.data(), load.count, created.data(), created.size(), textures);
+    }
+    return true;
+}
+
+// Axis-aligned extent used to place an entity: its collider if it has one,
+// else its sprite, else a point.
+void streamingBounds(ECS& ecs, Entity entity, float& x, float& y, float& width, float& height) {
+    const Transform& transform = ecs.getComponent<Transform>(entity);
+    x = transform.x;
+    y = transform.y;
+    width = 0.0f;
+    height = 0.0f;
+    if (ecs.hasComponent<Collider>(entity)) {
+        const Collider& collider = ecs.getComponent<Collider>(entity);
+        x += collider.offsetX;
+        y += collider.offsetY;
+        width = collider.width;
+        height = collider.height;
+    } else if (ecs.hasComponent<Sprite>(entity)) {
+        const Sprite& sprite = ecs.getComponent<Sprite>(entity);
+        width = sprite.width * transform.scaleX;
+        height = sprite.height * transform.scaleY;
+    }
+}
+
+// Splits the world into a streamed level. Each entity goes to the region
+// containing its center. Players, anything larger than a region (a ground
+// strip spanning the level would otherwise vanish with one corner), and
+// everything attached to those, go to the resident chunk. Attached entities
+// follow the root of their hierarchy. Particles are transient and are not
+// written at all.
+bool writeRegionLevel(ECS& ecs, const SceneRegistry& registry, const SceneTextures& textures,
+                      const std::string& directory, int regionSize, int worldWidth, int worldHeight,
+                      std::string& error) {
+    if (!hostIsLittleEndian()) {
+        error = "region files are little-endian and this host is not";
+        return false;
+    }
+    if (regionSize <= 0 || worldWidth <= 0 || worldHeight <= 0) {
+        error = "region size and world size must be positive";
+        return false;
+    }
+
+    std::error_code ignored;
+    std::filesystem::create_directories(directory, ignored);
+
+    RegionLevel level;
+    level.regionSize = (std::uint32_t)regionSize;
+    level.regionsX = (std::uint32_t)((worldWidth + regionSize - 1) / regionSize);
+    level.regionsY = (std::uint32_t)((worldHeight + regionSize - 1) / regionSize);
+    level.worldWidth = (std::uint32_t)worldWidth;
+    level.worldHeight = (std::uint32_t)worldHeight;
+    level.present.assign((size_t)level.regionsX * level.regionsY, 0);
+
+    const std::int32_t RESIDENT = -1;
+    const std::int32_t SKIPPED = -2;
+    std::vector<std::int32_t> regionOf(ecs.entities().entityCapacityUsed(), SKIPPED);
+    for (Entity entity = 0; entity < ecs.entities().entityCapacityUsed(); ++entity) {
+        if (!ecs.entities().isAlive(entity) || ecs.hasComponent<Particle>(entity)) continue;
+        if (ecs.hasComponent<PlayerController>(entity) || !ecs.hasComponent<Transform>(entity)) {
+            regionOf[entity] = RESIDENT;
+            continue;
+        }
+        float x, y, width, height;
+        streamingBounds(ecs, entity, x, y, width, height);
+        if (width > regionSize || height > regionSize) {
+            regionOf[entity] = RESIDENT;
+            continue;
+        }
+        int regionX = std::clamp((int)std::floor((x + width * 0.5f) / regionSize), 0, (int)level.regionsX - 1);
+        int regionY = std::clamp((int)std::floor((y + height * 0.5f) / regionSize), 0, (int)level.regionsY - 1);
+        regionOf[entity] = regionY * (std::int32_t)level.regionsX + regionX;
+    }
+
+    // Attached entities take their root's region; a chain that loops or
+    // breaks keeps the region of where it stops.
+    std::vector<std::int32_t> placed = regionOf;
+    for (Entity entity = 0; entity < regionOf.size(); ++entity) {
+        if (regionOf[entity] == SKIPPED || !ecs.hasComponent<Parent>(entity)) continue;
+        Entity root = entity;
+        for (size_t steps = 0; steps < regionOf.size() && ecs.hasComponent<Parent>(root); ++steps) {
+            Entity parent = ecs.getComponent<Parent>(root).entity;
+            if (parent >= regionOf.size() || regionOf[parent] == SKIPPED) break;
+            root = parent;
+        }
+        placed[entity] = regionOf[root];
+    }
+
+    std::vector<std::vector<Entity>> members(level.present.size());
+    std::vector<Entity> resident;
+    for (Entity entity = 0; entity < placed.size(); ++entity) {
+        if (placed[entity] == RESIDENT) resident.push_back(entity);
+        else if (placed[entity] >= 0) members[placed[entity]].push_back(entity);
+    }
+
+    std::vector<Entity> localIndex;
+    std::vector<std::uint8_t> chunk;
+    serializeRegionChunk(ecs, registry, textures, resident.data(), resident.size(), localIndex, chunk);
+    if (!writeRegionFile(directory + "/resident.gerc", chunk.data(), chunk.size())) {
+        error = "could not write " + directory + "/resident.gerc";
+        return false;
+    }
+    for (size_t region = 0; region < members.size(); ++region) {
+        int regionX = (int)(region % level.regionsX);
+        int regionY = (int)(region / level.regionsX);
+        std::string path = regionChunkPath(directory, regionX, regionY);
+        if (members[region].empty()) {
+            std::filesystem::remove(path, ignored);
+            continue;
+        }
+        serializeRegionChunk(ecs, registry, textures, members[region].data(), members[region].size(), localIndex, chunk);
+        if (!writeRegionFile(path, chunk.data(), chunk.size())) {
+            error = "could not write " + path;
+            return false;
+        }
+        level.present[region] = 1;
+    }
+
+    RegionLevelHeader header{};
+    std::memcpy(header.magic, REGION_LEVEL_MAGIC, sizeof(header.magic));
+    header.version = REGION_FORMAT_VERSION;
+    header.byteOrder = SCENE_BYTE_ORDER_MARK;
+    header.regionSize = level.regionSize;
+    header.regionsX = level.regionsX;
+    header.regionsY = level.regionsY;
+    header.worldWidth = level.worldWidth;
+    header.worldHeight = level.worldHeight;
+    header.textureCount = (std::uint32_t)textures.paths.size();
+
+    std::vector<std::uint8_t> manifest((const std::uint8_t*)&header, (const std::uint8_t*)&header + sizeof(header));
+    manifest.insert(manifest.end(), level.present.begin(), level.present.end());
+    for (const std::string& path : textures.paths) {
+        std::uint32_t length = (std::uint32_t)path.size();
+        manifest.insert(manifest.end(), (const std::uint8_t*)&length, (const std::uint8_t*)&length + sizeof(length));
+        manifest.insert(manifest.end(), path.begin(), path.end());
+    }
+    if (!writeRegionFile(directory + "/level.gerl", manifest.data(), manifest.size())) {
+        error = "could not write " + directory + "/level.gerl";
+        return false;
+    }
+    return true;
+}
+
+bool readRegionLevel(const std::string& directory, RegionLevel& level, std::string& error) {
+    std::vector<std::uint8_t> bytes;
+    if (!readRegionFile(directory + "/level.gerl", bytes)) {
+        error = "could not read " + directory + "/level.gerl";
+        return false;
+    }
+    RegionLevelHeader header;
+    if (bytes.size() < sizeof(header)) {
+        error = "level manifest is truncated";
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, REGION_LEVEL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REGION_FORMAT_VERSION || header.byteOrder != SCENE_BYTE_ORDER_MARK) {
+        error = "not a region level of version " + std::to_string(REGION_FORMAT_VERSION);
+        return false;
+    }
+
+    std::uint64_t regionCount = (std::uint64_t)header.regionsX * header.regionsY;
+    if (header.regionSize == 0 || regionCount > bytes.size() - sizeof(header)) {
+        error = "level manifest is corrupt";
+        return false;
+    }
+    level.regionSize = header.regionSize;
+    level.regionsX = header.regionsX;
+    level.regionsY = header.regionsY;
+    level.worldWidth = header.worldWidth;
+    level.worldHeight = header.worldHeight;
+    size_t offset = sizeof(header);
+    level.present.assign(bytes.begin() + offset, bytes.begin() + offset + (size_t)regionCount);
+    offset += (size_t)regionCount;
+
+    level.texturePaths.clear();
+    for (std::uint32_t i = 0; i < header.textureCount; ++i) {
+        std::uint32_t length;
+        if (bytes.size() - offset < sizeof(length)) {
+            error = "level texture table is corrupt";
+            return false;
+        }
+        std::memcpy(&length, bytes.data() + offset, sizeof(length));
+        offset += sizeof(length);
+        if (bytes.size() - offset < length) {
+            error = "level texture table is corrupt";
+            return false;
+        }
+        level.texturePaths.emplace_back((const char*)bytes.data() + offset, length);
+        offset += length;
+    }
+    return true;
+}
+
+struct WorldStreamingConfig {
+    // Margins around the camera's view, in world units. Regions come in when
+    // they get within activateMargin and only go out past deactivateMargin,
+    // so a camera idling on a region border does not thrash. Chunk files are
+    // read ahead of time within prefetchMargin.
+    float activateMargin = 256.0f;
+    float deactivateMargin = 768.0f;
+    float prefetchMargin = 1536.0f;
+    // Active regions further than viewMargin from the view are simulated
+    // every reducedRateInterval steps; 1 keeps them at full rate.
+    float viewMargin = 64.0f;
+    std::uint8_t reducedRateInterval = 4;
+    // Caps on resident work and memory: active regions (whose entities are
+    // in the ECS) and serialized chunk bytes held in memory. Chunks evicted
+    // with unsaved changes are written to the session directory.
+    size_t maxActiveRegions = 16;
+    size_t cacheBudgetBytes = 16u << 20;
+    // Spreads a burst of activations over several steps.
+    int maxActivationsPerUpdate = 2;
+};
+
+// Keeps only the part of a region level near the camera in the ECS. Each
+// region moves between Unloaded (on disk), Loading (read on the thread
+// pool), Loaded (chunk bytes in memory) and Active (entities in the ECS,
+// tagged with StreamedRegion). Deactivating a region serializes its
+// entities' current state back into its chunk, so the world keeps what
+// happened there. Entities stay with the region they were loaded from even
+// if they wander into another one.
+//
+// Main-thread (or simulation-thread) only, apart from the file I/O it hands
+// to the pool.
+class WorldStreamer {
+private:
+    enum class RegionState : std::uint8_t {
+        Unloaded,
+        Loading,
+        Loaded,
+        Active
+    };
+
+    struct Region {
+        int x = 0;
+        int y = 0;
+        RegionState state = RegionState::Unloaded;
+        bool dirty = false;
+        bool warm = false;
+        bool writing = false;
+        std::uint64_t lastUsed = 0;
+        // Kept while active too, so a rollback past the activation has
+        // something to fall back to.
+        std::shared_ptr<std::vector<std::uint8_t>> bytes;
+    };
+
+    struct Completion {
+        std::uint64_t key;
+        bool write;
+        bool ok;
+        std::shared_ptr<std::vector<std::uint8_t>> bytes;
+    };
+
+    struct RegionRange {
+        int minX, minY, maxX, maxY;
+
+        bool contains(int x, int y) const {
+            return x >= minX && x <= maxX && y >= minY && y <= maxY;
+        }
+    };
+
+    ThreadPool& pool;
+    const SceneRegistry& registry;
+    WorldStreamingConfig config;
+    SceneTextures textures;
+    RegionLevel level;
+    std::string directory;
+    std::string sessionDirectory;
+    std::vector<std::uint8_t> saved;
+    std::unordered_map<std::uint64_t, Region> regions;
+    std::uint64_t updateCount = 0;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+    std::vector<Completion> draining;
+    std::atomic<int> inFlight{0};
+
+    std::vector<Entity> members;
+    std::vector<Entity> created;
+    std::vector<Entity> activated;
+    std::vector<Entity> localIndex;
+    std::vector<std::pair<float, std::uint64_t>> candidates;
+
+    static std::uint64_t regionKey(int x, int y) {
+        return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y;
+    }
+
+    RegionRange rangeAround(const Camera& camera, float margin) const {
+        float size = (float)level.regionSize;
+        return RegionRange{
+            std::max(0, (int)std::floor((camera.x - margin) / size)),
+            std::max(0, (int)std::floor((camera.y - margin) / size)),
+            std::min((int)level.regionsX - 1, (int)std::floor((camera.x + camera.width + margin) / size)),
+            std::min((int)level.regionsY - 1, (int)std::floor((camera.y + camera.height + margin) / size))
+        };
+    }
+
+    bool hasChunk(int x, int y) const {
+        return level.isPresent(x, y) || saved[(size_t)y * level.regionsX + x] != 0;
+    }
+
+    void complete(Completion completion) {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        completions.push_back(std::move(completion));
+    }
+
+    void drainCompletions() {
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            if (completions.empty()) return;
+            draining.swap(completions);
+        }
+        for (Completion& completion : draining) {
+            --inFlight;
+            auto it = regions.find(completion.key);
+            if (it == regions.end()) continue;
+            Region& region = it->second;
+            if (completion.write) {
+                region.writing = false;
+                if (!completion.ok) {
+                    std::cout << "Failed to save region " << region.x << "," << region.y << std::endl;
+                }
+                if (region.state == RegionState::Unloaded) regions.erase(it);
+                continue;
+            }
+            if (completion.ok) {
+                region.bytes = std::move(completion.bytes);
+                // A rollback may have brought the region's entities back in
+                // the meantime.
+                if (region.state != RegionState::Active) region.state = RegionState::Loaded;
+            } else {
+                std::cout << "Failed to read region " << region.x << "," << region.y << std::endl;
+                // An active region still has its entities; anything else is
+                // dropped from the level.
+                if (region.state != RegionState::Active) {
+                    level.present[(size_t)region.y * level.regionsX + region.x] = 0;
+                    saved[(size_t)region.y * level.regionsX + region.x] = 0;
+                    regions.erase(it);
+                }
+            }
+        }
+        draining.clear();
+    }
+
+    void requestLoad(Region& region) {
+        // An evicted chunk still being written can be taken back as-is.
+        if (region.bytes != nullptr) {
+            region.state = RegionState::Loaded;
+            return;
+        }
+        if (region.writing) return;
+
+        bool fromSession = saved[(size_t)region.y * level.regionsX + region.x] != 0;
+        std::string path = regionChunkPath(fromSession ? sessionDirectory : directory, region.x, region.y);
+        std::uint64_t key = regionKey(region.x, region.y);
+        region.state = RegionState::Loading;
+        ++inFlight;
+        pool.submit([this, key, path] {
+            PROFILE_SCOPE("readRegion");
+            auto bytes = std::make_shared<std::vector<std::uint8_t>>();
+            bool ok = readRegionFile(path, *bytes);
+            complete(Completion{key, false, ok, std::move(bytes)});
+        });
+    }
+
+    void gatherMembers(ECS& ecs, int x, int y) {
+        members.clear();
+        ComponentArrayImpl<StreamedRegion>& tags = ecs.pool<StreamedRegion>();
+        const StreamedRegion* regionTags = tags.components();
+        const Entity* entities = tags.entities();
+        for (size_t i = 0; i < tags.count(); ++i) {
+            if (regionTags[i].x == x && regionTags[i].y == y) members.push_back(entities[i]);
+        }
+    }
+
+    bool activate(ECS& ecs, Region& region) {
+        PROFILE_SCOPE("activateRegion");
+        std::string error;
+        if (!instantiateRegionChunk(ecs, registry, textures, region.bytes->data(), region.bytes->size(), created, error)) {
+            std::cout << "Failed to activate region " << region.x << "," << region.y << ": " << error << std::endl;
+            return false;
+        }
+        for (Entity entity : created) {
+            ecs.addComponent(entity, StreamedRegion{region.x, region.y});
+        }
+        activated.insert(activated.end(), created.begin(), created.end());
+        region.state = RegionState::Active;
+        region.warm = false;
+        return true;
+    }
+
+    // One streaming pass; update and loadAround collect what it activates.
+    bool advance(ECS& ecs, const Camera& camera) {
+        PROFILE_SCOPE("worldStreaming");
+        ++updateCount;
+        drainCompletions();
+        bool changed = false;
+
+        RegionRange prefetch = rangeAround(camera, config.prefetchMargin);
+        for (int y = prefetch.minY; y <= prefetch.maxY; ++y) {
+            for (int x = prefetch.minX; x <= prefetch.maxX; ++x) {
+                if (!hasChunk(x, y)) continue;
+                Region& region = regions[regionKey(x, y)];
+                region.x = x;
+                region.y = y;
+                region.lastUsed = updateCount;
+                if (region.state == RegionState::Unloaded) requestLoad(region);
+            }
+        }
+
+        RegionRange keep = rangeAround(camera, config.deactivateMargin);
+        for (auto& entry : regions) {
+            Region& region = entry.second;
+            if (region.state == RegionState::Active && !keep.contains(region.x, region.y)) {
+                deactivate(ecs, region);
+                changed = true;
+            }
+        }
+
+        // Nearest first, so the capped activations go where the camera is.
+        RegionRange near = rangeAround(camera, config.activateMargin);
+        float centerX = camera.x + camera.width * 0.5f;
+        float centerY = camera.y + camera.height * 0.5f;
+        candidates.clear();
+        for (int y = near.minY; y <= near.maxY; ++y) {
+            for (int x = near.minX; x <= near.maxX; ++x) {
+                auto it = regions.find(regionKey(x, y));
+                if (it == regions.end() || it->second.state != RegionState::Loaded) continue;
+                float dx = (x + 0.5f) * level.regionSize - centerX;
+                float dy = (y + 0.5f) * level.regionSize - centerY;
+                candidates.emplace_back(dx * dx + dy * dy, it->first);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        size_t active = activeCount();
+        int activations = 0;
+        for (const auto& candidate : candidates) {
+            if (activations >= config.maxActivationsPerUpdate || active >= config.maxActiveRegions) break;
+            if (activate(ecs, regions[candidate.second])) {
+                ++active;
+                ++activations;
+                changed = true;
+            }
+        }
+
+        RegionRange view = rangeAround(camera, config.viewMargin);
+        for (auto& entry : regions) {
+            Region& region = entry.second;
+            if (region.state != RegionState::Active) continue;
+            bool warm = config.reducedRateInterval > 1 && !view.contains(region.x, region.y);
+            if (warm != region.warm) setWarm(ecs, region, warm);
+        }
+        advanceReducedRates(ecs);
+
+        evict();
+        return changed;
+    }
+
+    void deactivate(ECS& ecs, Region& region) {
+        PROFILE_SCOPE("deactivateRegion");
+        gatherMembers(ecs, region.x, region.y);
+        // The writer may still hold the old buffer.
+        if (region.bytes == nullptr || region.bytes.use_count() > 1) {
+            region.bytes = std::make_shared<std::vector<std::uint8_t>>();
+        }
+        serializeRegionChunk(ecs, registry, textures, members.data(), members.size(), localIndex, *region.bytes);
+        for (Entity entity : members) {
+            ecs.destroyEntity(entity);
+        }
+        region.state = RegionState::Loaded;
+        region.dirty = true;
+        region.warm = false;
+    }
+
+    void setWarm(ECS& ecs, Region& region, bool warm) {
+        gatherMembers(ecs, region.x, region.y);
+        for (size_t i = 0; i < members.size(); ++i) {
+            if (warm) {
+                std::uint8_t interval = config.reducedRateInterval;
+                ecs.addComponent(members[i], ReducedRate{interval, (std::uint8_t)(i % interval)});
+            } else {
+                ecs.removeComponent<ReducedRate>(members[i]);
+            }
+        }
+        region.warm = warm;
+    }
+
+    void advanceReducedRates(ECS& ecs) {
+        ComponentArrayImpl<ReducedRate>& rates = ecs.pool<ReducedRate>();
+        ReducedRate* rate = rates.components();
+        for (size_t i = 0; i < rates.count(); ++i) {
+            rate[i].countdown = rate[i].countdown == 0 ? rate[i].interval - 1 : rate[i].countdown - 1;
+        }
+    }
+
+    size_t activeCount() const {
+        size_t count = 0;
+        for (const auto& entry : regions) {
+            if (entry.second.state == RegionState::Active) ++count;
+        }
+        return count;
+    }
+
+    // Drops the least recently wanted inactive chunks until the cached bytes
+    // fit the budget. Chunks with unsaved changes are written out first.
+    void evict() {
+        for (;;) {
+            size_t total = cachedBytes();
+            if (total <= config.cacheBudgetBytes) return;
+
+            Region* victim = nullptr;
+            for (auto& entry : regions) {
+                Region& region = entry.second;
+                if (region.state != RegionState::Loaded || region.lastUsed == updateCount) continue;
+                if (victim == nullptr || region.lastUsed < victim->lastUsed) victim = &region;
+            }
+            if (victim == nullptr) return;
+
+            std::uint64_t key = regionKey(victim->x, victim->y);
+            victim->state = RegionState::Unloaded;
+            if (victim->dirty) {
+                saved[(size_t)victim->y * level.regionsX + victim->x] = 1;
+                std::string path = regionChunkPath(sessionDirectory, victim->x, victim->y);
+                auto bytes = std::move(victim->bytes);
+                victim->dirty = false;
+                victim->writing = true;
+                ++inFlight;
+                pool.submit([this, key, path, bytes] {
+                    PROFILE_SCOPE("writeRegion");
+                    bool ok = writeRegionFile(path, bytes->data(), bytes->size());
+                    complete(Completion{key, true, ok, nullptr});
+                });
+            } else if (!victim->writing) {
+                regions.erase(key);
+            } else {
+                victim->bytes.reset();
+            }
+        }
+    }
+
+public:
+    WorldStreamer(ThreadPool& pool, const SceneRegistry& registry, WorldStreamingConfig config = WorldStreamingConfig())
+        : pool(pool), registry(registry), config(config) {
+        this->config.reducedRateInterval = std::max<std::uint8_t>(1, this->config.reducedRateInterval);
+    }
+
+    // Waits for reads and writes in flight, since they hold a pointer to
+    // the streamer.
+    ~WorldStreamer() {
+        pool.waitIdle();
+        drainCompletions();
+    }
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    // Reads the manifest and instantiates the resident chunk. Textures are
+    // resolved by path as in loadScene. Chunks changed during the session are
+    // written under <directory>/session, which is cleared here so the level
+    // on disk itself is never modified.
+    bool open(ECS& ecs, const std::string& levelDirectory, const SceneTextures& callerTextures, std::string& error) {
+        if (!readRegionLevel(levelDirectory, level, error)) return false;
+        directory = levelDirectory;
+        sessionDirectory = levelDirectory + "/session";
+        std::error_code ignored;
+        std::filesystem::remove_all(sessionDirectory, ignored);
+        std::filesystem::create_directories(sessionDirectory, ignored);
+        saved.assign(level.present.size(), 0);
+
+        textures = SceneTextures();
+        for (const std::string& path : level.texturePaths) {
+            size_t match = callerTextures.find(path);
+            if (match < callerTextures.paths.size()) {
+                textures.add(path, callerTextures.textures[match], callerTextures.assets[match]);
+            } else {
+                textures.add(path, nullptr);
+            }
+        }
+
+        std::vector<std::uint8_t> resident;
+        if (!readRegionFile(directory + "/resident.gerc", resident)) {
+            error = "could not read " + directory + "/resident.gerc";
+            return false;
+        }
+        return instantiateRegionChunk(ecs, registry, textures, resident.data(), resident.size(), created, error);
+    }
+
+    // Once per simulation step, before the systems run. Returns true if
+    // entities were added to or removed from the ECS.
+    bool update(ECS& ecs, const Camera& camera) {
+        activated.clear();
+        return advance(ecs, camera);
+    }
+
+    // Blocks until every region within activateMargin of the camera is
+    // active, ignoring maxActivationsPerUpdate. For loading screens and the
+    // first frame, not for use mid-game.
+    bool loadAround(ECS& ecs, const Camera& camera) {
+        activated.clear();
+        bool changed = advance(ecs, camera);
+        pool.waitIdle();
+        int activationCap = config.maxActivationsPerUpdate;
+        config.maxActivationsPerUpdate = std::numeric_limits<int>::max();
+        changed = advance(ecs, camera) || changed;
+        config.maxActivationsPerUpdate = activationCap;
+        return changed;
+    }
+
+    // Entities the last update or loadAround brought in from region chunks,
+    // e.g. to schedule their timers. Valid until the next of either.
+    const std::vector<Entity>& activatedEntities() const {
+        return activated;
+    }
+
+    // After the ECS was rolled back: the entities present decide which
+    // regions are active. A region activated after the restored point falls
+    // back to the chunk it was activated from.
+    void resync(ECS& ecs) {
+        for (auto& entry : regions) {
+            Region& region = entry.second;
+            region.warm = false;
+            if (region.state == RegionState::Active) {
+                region.state = region.bytes != nullptr ? RegionState::Loaded : RegionState::Unloaded;
+            }
+        }
+        ComponentArrayImpl<StreamedRegion>& tags = ecs.pool<StreamedRegion>();
+        for (size_t i = 0; i < tags.count(); ++i) {
+            const StreamedRegion& tag = tags.components()[i];
+            Region& region = regions[regionKey(tag.x, tag.y)];
+            region.x = tag.x;
+            region.y = tag.y;
+            region.state = RegionState::Active;
+            region.lastUsed = updateCount;
+        }
+        ecs.pool<ReducedRate>().clear();
+    }
+
+    const RegionLevel& levelInfo() const {
+        return level;
+    }
+
+    size_t activeRegionCount() const {
+        return activeCount();
+    }
+
+    size_t cachedRegionCount() const {
+        size_t count = 0;
+        for (const auto& entry : regions) {
+            if (entry.second.bytes != nullptr) ++count;
+        }
+        return count;
+    }
+
+    size_t cachedBytes() const {
+        size_t total = 0;
+        for (const auto& entry : regions) {
+            if (entry.second.bytes != nullptr) total += entry.second.bytes->capacity();
+        }
+        return total;
+    }
+
+    int pendingCount() const {
+        return inFlight.load();
+    }
+};
@@ -4,188 +4,861 @@
 #include <SDL_mixer.h>
 #include <iostream>
 #include <cmath>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include "AllocationCounter.h"
 #include "ECS.h"
 #include "Components.h"
 #include "PhysicsSystem.h"
 #include "AnimationSystem.h"
+#include "RenderSnapshot.h"
+#include "StaticLayerCache.h"
+#include "DrawQueue.h"
+#include "RenderBackend.h"
+#include "SoftwareRenderer.h"
+#include "FramePacer.h"
+#include "RenderSystem.h"
+#include "Profiler.h"
+#include "MemoryStats.h"
+#include "SceneFile.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "AudioManager.h"
+#include "SnapshotHistory.h"
+#include "TransformHierarchy.h"
+#include "WorldStreaming.h"
+#include "Prefab.h"
+#include "Random.h"
+#include "Navigation.h"
 #include <SDL_ttf.h>
 
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 const int WORLD_WIDTH = 2000;
 const int WORLD_HEIGHT = 1500;
+const int REGION_SIZE = 512;
+const float NAV_CELL_SIZE = 32.0f;
+const float ENEMY_RADIUS = 16.0f;
 
-struct Camera {
-    float x;
-    float y;
-    int width;
-    int height;
+// The demo world by default; a streamed level brings its own size.
+struct WorldBounds {
+    float width = WORLD_WIDTH;
+    float height = WORLD_HEIGHT;
 };
 
-void updateCamera(Camera& camera, float targetX, float targetY) {
+void updateCamera(Camera& camera, const WorldBounds& bounds, float targetX, float targetY) {
     camera.x = targetX - camera.width / 2;
     camera.y = targetY - camera.height / 2;
 
     if (camera.x < 0) camera.x = 0;
     if (camera.y < 0) camera.y = 0;
-    if (camera.x > WORLD_WIDTH - camera.width) camera.x = WORLD_WIDTH - camera.width;
-    if (camera.y > WORLD_HEIGHT - camera.height) camera.y = WORLD_HEIGHT - camera.height;
+    if (camera.x > bounds.width - camera.width) camera.x = bounds.width - camera.width;
+    if (camera.y > bounds.height - camera.height) camera.y = bounds.height - camera.height;
 }
 
-void movementSystem(ECS& ecs, float deltaTime) {
-    auto entities = ecs.getEntitiesWithComponent<Velocity>();
+void movementSystem(ECS& ecs, const WorldBounds& bounds, float deltaTime) {
+    auto entities = ecs.getEntitiesWithComponent<Velocity>(frameArena());
+    auto& reducedRates = ecs.pool<ReducedRate>();
     
     for (Entity entity : entities) {
         if (ecs.hasComponent<Transform>(entity)) {
+            float stepTime = deltaTime;
+            if (reducedRates.count() > 0 && reducedRates.hasData(entity)) {
+                stepTime = reducedRateStep(reducedRates.getData(entity), deltaTime);
+                if (stepTime == 0.0f) continue;
+            }
             auto& transform = ecs.getComponent<Transform>(entity);
             auto& velocity = ecs.getComponent<Velocity>(entity);
             
-            transform.x += velocity.vx * deltaTime;
-            transform.y += velocity.vy * deltaTime;
+            transform.x += velocity.vx * stepTime;
+            transform.y += velocity.vy * stepTime;
 
             if (transform.x < 0) {
                 transform.x = 0;
                 velocity.vx = 0;
             }
-            if (transform.x > WORLD_WIDTH - 64) {
-                transform.x = WORLD_WIDTH - 64;
+            if (transform.x > bounds.width - 64) {
+                transform.x = bounds.width - 64;
                 velocity.vx = 0;
             }
-            if (transform.y > WORLD_HEIGHT - 64) {
-                transform.y = WORLD_HEIGHT - 64;
+            if (transform.y > bounds.height - 64) {
+                transform.y = bounds.height - 64;
                 velocity.vy = 0;
             }
         }
     }
 }
 
-void renderSystem(ECS& ecs, SDL_Renderer* renderer, Camera& camera) {
-    auto entities = ecs.getEntitiesWithComponent<Sprite>();
-    
-    for (Entity entity : entities) {
-        if (ecs.hasComponent<Transform>(entity)) {
-            auto& transform = ecs.getComponent<Transform>(entity);
-            auto& sprite = ecs.getComponent<Sprite>(entity);
-            
-            int screenX = (int)(transform.x - camera.x);
-            int screenY = (int)(transform.y - camera.y);
-            
-            int scaledWidth = (int)(sprite.width * transform.scaleX);
-            int scaledHeight = (int)(sprite.height * transform.scaleY);
-            
-            SDL_Rect destRect = {screenX, screenY, scaledWidth, scaledHeight};
-            
-            SDL_Rect srcRect = {sprite.srcX, sprite.srcY, sprite.srcWidth, sprite.srcHeight};
-            
-            if (sprite.srcWidth == 0 || sprite.srcHeight == 0) {
-                SDL_RenderCopyEx(
-                    renderer,
-                    (SDL_Texture*)sprite.texture,
-                    NULL,
-                    &destRect,
-                    transform.rotation,
-                    NULL,
-                    SDL_FLIP_NONE
-                );
-            } else {
-                SDL_RenderCopyEx(
-                    renderer,
-                    (SDL_Texture*)sprite.texture,
-                    &srcRect,
-                    &destRect,
-                    transform.rotation,
-                    NULL,
-                    SDL_FLIP_NONE
-                );
-            }
-        }
-    }
-}
-
-void renderParticles(ECS& ecs, SDL_Renderer* renderer, Camera& camera) {
-    auto particles = ecs.getEntitiesWithComponent<Particle>();
-    
-    for (Entity entity : particles) {
-        if (ecs.hasComponent<Transform>(entity)) {
-            auto& transform = ecs.getComponent<Transform>(entity);
-            auto& particle = ecs.getComponent<Particle>(entity);
-            
-            int screenX = (int)(transform.x - camera.x);
-            int screenY = (int)(transform.y - camera.y);
-            
-            SDL_SetRenderDrawColor(renderer, 
-                particle.colorR, 
-                particle.colorG, 
-                particle.colorB, 
-                particle.colorA);
-            
-            SDL_Rect rect = {screenX, screenY, 8, 8};
-            SDL_RenderFillRect(renderer, &rect);
-        }
-    }
-}
-
-void renderText(SDL_Renderer* renderer, TTF_Font* font, const char* text, int x, int y, SDL_Color color) {
+void renderText(RenderBackend& backend, TTF_Font* font, const char* text, int x, int y, SDL_Color color) {
     SDL_Surface* surface = TTF_RenderText_Solid(font, text, color);
     if (surface == nullptr) return;
     
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    void* texture = backend.createTexture(surface);
     if (texture == nullptr) {
         SDL_FreeSurface(surface);
         return;
     }
     
     SDL_Rect destRect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(renderer, texture, NULL, &destRect);
+    backend.drawTexture(texture, NULL, destRect, 0.0);
     
-    SDL_DestroyTexture(texture);
+    backend.destroyTexture(texture);
     SDL_FreeSurface(surface);
 }
 
-void renderHealthBar(SDL_Renderer* renderer, int x, int y, int width, int height, int current, int max) {
-    SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
+void renderHealthBar(RenderBackend& backend, int x, int y, int width, int height, int current, int max) {
+    backend.setDrawColor(100, 100, 100, 255);
     SDL_Rect bgRect = {x, y, width, height};
-    SDL_RenderFillRect(renderer, &bgRect);
+    backend.fillRect(bgRect);
     
     float healthPercent = (float)current / (float)max;
     int healthWidth = (int)(width * healthPercent);
     
     if (healthPercent > 0.6f) {
-        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+        backend.setDrawColor(0, 255, 0, 255);
     } else if (healthPercent > 0.3f) {
-        SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+        backend.setDrawColor(255, 255, 0, 255);
     } else {
-        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        backend.setDrawColor(255, 0, 0, 255);
     }
     
     SDL_Rect healthRect = {x, y, healthWidth, height};
-    SDL_RenderFillRect(renderer, &healthRect);
+    backend.fillRect(healthRect);
     
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderDrawRect(renderer, &bgRect);
+    backend.setDrawColor(255, 255, 255, 255);
+    backend.drawRect(bgRect);
 }
 
-void debugRenderColliders(ECS& ecs, SDL_Renderer* renderer, Camera& camera) {
-    auto entities = ecs.getEntitiesWithComponent<Collider>();
-    
-    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-    
+void logFrameTimes(const FrameStats& frameStats) {
+    std::cout << "Frame times over " << frameStats.count << " frames: p50 " << frameStats.p50Ms
+              << " ms, p95 " << frameStats.p95Ms << " ms, p99 " << frameStats.p99Ms
+              << " ms, max " << frameStats.maxMs << " ms, missed " << frameStats.missedInWindow
+              << " (" << frameStats.totalMissed << " total)" << std::endl;
+}
+
+void renderFrame(const RenderSnapshot& snapshot, float alpha, RenderBackend& backend, StaticLayerCache& staticLayer,
+                 DrawQueue& drawQueue, TTF_Font* font, bool showColliders, int currentFPS,
+                 const FrameStats& frameStats, std::uint64_t renderAllocations) {
+    Camera camera = {
+        interpolate(snapshot.prevCameraX, snapshot.cameraX, alpha),
+        interpolate(snapshot.prevCameraY, snapshot.cameraY, alpha),
+        SCREEN_WIDTH,
+        SCREEN_HEIGHT
+    };
+
+    backend.setDrawColor(30, 30, 46, 255);
+    backend.clear();
+
+    {
+        PROFILE_SCOPE("staticLayer");
+        staticLayer.sync(snapshot.platforms);
+        staticLayer.render(camera.x, camera.y, camera.width, camera.height);
+    }
+
+    { PROFILE_SCOPE("drawQueue.build"); drawQueue.build(snapshot, showColliders); }
+    { PROFILE_SCOPE("renderSystem"); renderSystem(drawQueue, snapshot, backend, camera, alpha); }
+
+    if (font != nullptr) {
+        PROFILE_SCOPE("hud");
+        const HudState& hud = snapshot.hud;
+        
+        renderHealthBar(backend, 10, 10, 200, 20, hud.health, hud.maxHealth);
+        
+        char healthText[32];
+        sprintf(healthText, "HP: %d/%d", hud.health, hud.maxHealth);
+        SDL_Color white = {255, 255, 255, 255};
+        renderText(backend, font, healthText, 10, 35, white);
+        
+        char fpsText[32];
+        sprintf(fpsText, "FPS: %d", currentFPS);
+        renderText(backend, font, fpsText, 10, 65, white);
+        
+        char posText[64];
+        sprintf(posText, "Pos: (%.0f, %.0f)", hud.playerX, hud.playerY);
+        renderText(backend, font, posText, 10, 95, white);
+        
+        char frameText[96];
+        sprintf(frameText, "ms p50 %.1f p95 %.1f p99 %.1f max %.1f",
+                frameStats.p50Ms, frameStats.p95Ms, frameStats.p99Ms, frameStats.maxMs);
+        renderText(backend, font, frameText, 10, 125, white);
+        
+        char missedText[64];
+        sprintf(missedText, "Missed: %d (%d total)", frameStats.missedInWindow, frameStats.totalMissed);
+        renderText(backend, font, missedText, 10, 155, white);
+        
+        char allocText[64];
+        sprintf(allocText, "Allocs: sim %llu render %llu",
+                (unsigned long long)snapshot.simulationAllocations, (unsigned long long)renderAllocations);
+        renderText(backend, font, allocText, 10, 185, white);
+        
+        const HeapCounters& heap = heapCounters();
+        char heapText[96];
+        sprintf(heapText, "Heap %.1f MB peak %.1f MB tex %.1f MB",
+                heap.liveBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0),
+                heap.peakBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0),
+                backend.textureBytes() / (1024.0 * 1024.0));
+        renderText(backend, font, heapText, 10, 215, white);
+        
+        renderText(backend, font, "H - Damage  J - Heal", 10, SCREEN_HEIGHT - 30, white);
+    }
+}
+
+// One row per profiled scope: average ms as a bar (a 60 Hz frame spans the
+// full width) with a tick at the worst sample, grouped under thread headers.
+void renderProfilerOverlay(RenderBackend& backend, TTF_Font* font, const std::vector<ProfileSummaryEntry>& entries) {
+    const int PANEL_X = 240;
+    const int BAR_X = 560;
+    const int BAR_WIDTH = 200;
+    const int ROW_HEIGHT = 20;
+    const float FRAME_MS = 1000.0f / 60.0f;
+
+    int rows = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        rows += (i == 0 || entries[i].threadName != entries[i - 1].threadName) ? 2 : 1;
+    }
+
+    backend.setDrawColor(0, 0, 0, 180);
+    SDL_Rect panel = {PANEL_X, 5, SCREEN_WIDTH - PANEL_X - 5, std::min(rows * ROW_HEIGHT + 10, SCREEN_HEIGHT - 45)};
+    backend.fillRect(panel);
+
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color yellow = {255, 220, 0, 255};
+    int y = 10;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ProfileSummaryEntry& entry = entries[i];
+        if (i == 0 || entry.threadName != entries[i - 1].threadName) {
+            if (y + ROW_HEIGHT * 2 > SCREEN_HEIGHT - 45) break;
+            if (font != nullptr) renderText(backend, font, entry.threadName.c_str(), PANEL_X + 10, y, yellow);
+            y += ROW_HEIGHT;
+        }
+        if (y + ROW_HEIGHT > SCREEN_HEIGHT - 45) break;
+
+        if (font != nullptr) {
+            char label[32];
+            sprintf(label, "%-16.16s %5.2f", entry.name.c_str(), entry.averageMs);
+            renderText(backend, font, label, PANEL_X + 10, y, white);
+        }
+
+        int averageWidth = std::min(BAR_WIDTH, (int)(entry.averageMs / FRAME_MS * BAR_WIDTH + 0.5f));
+        int maxOffset = std::min(BAR_WIDTH, (int)(entry.maxMs / FRAME_MS * BAR_WIDTH + 0.5f));
+
+        backend.setDrawColor(60, 60, 60, 255);
+        SDL_Rect track = {BAR_X, y + 2, BAR_WIDTH, ROW_HEIGHT - 6};
+        backend.fillRect(track);
+
+        backend.setDrawColor(0, 200, 120, 255);
+        SDL_Rect bar = {BAR_X, y + 2, std::max(1, averageWidth), ROW_HEIGHT - 6};
+        backend.fillRect(bar);
+
+        backend.setDrawColor(255, 80, 80, 255);
+        SDL_Rect maxTick = {BAR_X + std::max(0, maxOffset - 2), y, 2, ROW_HEIGHT - 2};
+        backend.fillRect(maxTick);
+
+        y += ROW_HEIGHT;
+    }
+}
+
+void storePreviousTransforms(ECS& ecs) {
+    auto entities = ecs.getEntitiesWithComponent<Transform>(frameArena());
+
     for (Entity entity : entities) {
-        if (ecs.hasComponent<Transform>(entity)) {
-            auto& transform = ecs.getComponent<Transform>(entity);
-            auto& collider = ecs.getComponent<Collider>(entity);
-            
-            int screenX = (int)(transform.x + collider.offsetX - camera.x);
-            int screenY = (int)(transform.y + collider.offsetY - camera.y);
-            
-            SDL_Rect rect = {screenX, screenY, (int)collider.width, (int)collider.height};
-            SDL_RenderDrawRect(renderer, &rect);
+        auto& transform = ecs.getComponent<Transform>(entity);
+        if (ecs.hasComponent<PreviousTransform>(entity)) {
+            auto& previous = ecs.getComponent<PreviousTransform>(entity);
+            previous.x = transform.x;
+            previous.y = transform.y;
+        } else {
+            ecs.addComponent(entity, PreviousTransform{transform.x, transform.y});
+        }
+    }
+}
+
+struct DemoScene {
+    Entity player;
+    Entity playerParticles;
+};
+
+DemoScene createDemoScene(ECS& ecs, const WorldBounds& bounds, const TextureAsset* spriteTexture, Random& random) {
+    Entity player = ecs.createEntity();
+    ecs.addComponent(player, Transform{400.0f, 100.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(player, Sprite{nullptr, 64, 64, 0, 0, 0, 0, spriteTexture});
+    ecs.addComponent(player, Velocity{0.0f, 0.0f});
+    ecs.addComponent(player, Collider{64.0f, 64.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(player, RigidBody{1.0f, true, 1.0f, false});
+    ecs.addComponent(player, PlayerController{300.0f, 500.0f, false});
+    ecs.addComponent(player, Health{100, 100});
+
+    Entity playerParticles = ecs.createEntity();
+    ecs.addComponent(playerParticles, Transform{432.0f, 164.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(playerParticles, ParticleEmitter{
+        20.0f, 0.5f, 0.0f, 50, true,
+        -50.0f, 50.0f, -100.0f, -50.0f
+    });
+    attachToParent(ecs, playerParticles, player, LocalTransform{32.0f, 64.0f, 0.0f, 1.0f, 1.0f});
+
+    Entity ground = ecs.createEntity();
+    ecs.addComponent(ground, Transform{0.0f, bounds.height - 100.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(ground, Collider{bounds.width, 100.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(ground, RigidBody{1.0f, false, 0.0f, true});
+
+    Entity platform1 = ecs.createEntity();
+    ecs.addComponent(platform1, Transform{300.0f, 800.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(platform1, Collider{400.0f, 50.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(platform1, RigidBody{1.0f, false, 0.0f, true});
+
+    Entity platform2 = ecs.createEntity();
+    ecs.addComponent(platform2, Transform{800.0f, 600.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(platform2, Collider{400.0f, 50.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(platform2, RigidBody{1.0f, false, 0.0f, true});
+
+    Entity platform3 = ecs.createEntity();
+    ecs.addComponent(platform3, Transform{1300.0f, 900.0f, 0.0f, 1.0f, 1.0f});
+    ecs.addComponent(platform3, Collider{300.0f, 50.0f, 0.0f, 0.0f, false});
+    ecs.addComponent(platform3, RigidBody{1.0f, false, 0.0f, true});
+
+    Prefab ballPrefab = Prefab("ball")
+        .with(Transform{0.0f, 0.0f, 0.0f, 1.0f, 1.0f})
+        .with(Sprite{nullptr, 64, 64, 0, 0, 0, 0, spriteTexture})
+        .with(Velocity{0.0f, 0.0f})
+        .with(Collider{64.0f, 64.0f, 0.0f, 0.0f, false})
+        .with(RigidBody{1.0f, true, 1.0f, false});
+
+    instantiate(ecs, ballPrefab, 5, [&](const PrefabBatch& balls) {
+        Transform* transforms = balls.components<Transform>();
+        Collider* colliders = balls.components<Collider>();
+        for (size_t i = 0; i < balls.size(); ++i) {
+            float randomX = 500.0f + (float)random.below(800);
+            float randomY = 200.0f + (float)random.below(300);
+            float randomScale = 0.5f + (float)random.below(100) / 100.0f;
+
+            transforms[i] = Transform{randomX, randomY, 0.0f, randomScale, randomScale};
+            colliders[i].width = 64.0f * randomScale;
+            colliders[i].height = 64.0f * randomScale;
+        }
+    });
+
+    // Flying enemies chase the player along the flow field. They have no
+    // collider, so they pass through each other and the player.
+    Prefab enemyPrefab = Prefab("enemy")
+        .with(Transform{0.0f, 0.0f, 0.0f, 0.5f, 0.5f})
+        .with(Sprite{nullptr, 64, 64, 0, 0, 0, 0, spriteTexture})
+        .with(Velocity{0.0f, 0.0f})
+        .with(NavAgent{120.0f, ENEMY_RADIUS});
+
+    instantiate(ecs, enemyPrefab, 8, [&](const PrefabBatch& enemies) {
+        Transform* transforms = enemies.components<Transform>();
+        for (size_t i = 0; i < enemies.size(); ++i) {
+            transforms[i].x = 100.0f + (float)random.below((int)bounds.width - 200);
+            transforms[i].y = 100.0f + (float)random.below(300);
         }
+    });
+
+    return DemoScene{player, playerParticles};
+}
+
+bool findDemoScene(ECS& ecs, DemoScene& scene) {
+    auto players = ecs.getEntitiesWithComponent<PlayerController>();
+    auto emitters = ecs.getEntitiesWithComponent<ParticleEmitter>();
+    if (players.empty() || emitters.empty() ||
+        !ecs.hasComponent<Transform>(players[0]) || !ecs.hasComponent<Transform>(emitters[0])) {
+        return false;
     }
+    scene = DemoScene{players[0], emitters[0]};
+    return true;
+}
+
+// Loads a scene file in place of createDemoScene. The player is the first
+// PlayerController and its emitter the first ParticleEmitter; whether the
+// emitter follows the player is up to the Parent stored in the file.
+bool loadDemoScene(ECS& ecs, const char* path, const SceneTextures& textures, DemoScene& scene) {
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    std::string error;
+    if (!loadScene(ecs, defaultSceneRegistry(), textures, path, error)) {
+        std::cout << "Failed to load scene " << path << ": " << error << std::endl;
+        return false;
+    }
+    double milliseconds = (double)(SDL_GetPerformanceCounter() - startCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    if (!findDemoScene(ecs, scene)) {
+        std::cout << "Scene " << path << " has no player or no particle emitter" << std::endl;
+        return false;
+    }
+
+    std::cout << "Loaded scene " << path << ": " << ecs.entities().livingCount() << " entities in "
+              << milliseconds << " ms" << std::endl;
+    return true;
+}
+
+bool saveDemoScene(ECS& ecs, const char* path, const SceneTextures& textures) {
+    std::string error;
+    if (!writeScene(ecs, defaultSceneRegistry(), textures, path, error)) {
+        std::cout << "Failed to write scene " << path << ": " << error << std::endl;
+        return false;
+    }
+    std::cout << "Wrote scene " << path << " (" << ecs.entities().livingCount() << " entities)" << std::endl;
+    return true;
+}
+
+// Streams a region level written by saveDemoRegions. Only the resident
+// chunk (the player and anything spanning several regions) is loaded here;
+// regions come in with the first updates.
+bool openDemoRegions(ECS& ecs, WorldStreamer& streamer, const char* path, const SceneTextures& textures,
+                     DemoScene& scene, WorldBounds& bounds) {
+    std::string error;
+    if (!streamer.open(ecs, path, textures, error)) {
+        std::cout << "Failed to open region level " << path << ": " << error << std::endl;
+        return false;
+    }
+    if (!findDemoScene(ecs, scene)) {
+        std::cout << "Region level " << path << " has no player or no particle emitter" << std::endl;
+        return false;
+    }
+    const RegionLevel& level = streamer.levelInfo();
+    bounds.width = (float)level.worldWidth;
+    bounds.height = (float)level.worldHeight;
+
+    const Transform& playerTransform = ecs.getComponent<Transform>(scene.player);
+    Camera camera = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    updateCamera(camera, bounds, playerTransform.x + 32, playerTransform.y + 32);
+    streamer.loadAround(ecs, camera);
+    std::cout << "Opened region level " << path << ": " << level.regionsX << "x" << level.regionsY << " regions of "
+              << level.regionSize << " units" << std::endl;
+    return true;
+}
+
+bool saveDemoRegions(ECS& ecs, const char* path, const SceneTextures& textures, const WorldBounds& bounds) {
+    std::string error;
+    if (!writeRegionLevel(ecs, defaultSceneRegistry(), textures, path, REGION_SIZE,
+                          (int)bounds.width, (int)bounds.height, error)) {
+        std::cout << "Failed to write region level " << path << ": " << error << std::endl;
+        return false;
+    }
+    std::cout << "Wrote region level " << path << std::endl;
+    return true;
+}
+
+struct SimulationState {
+    ExpiryWheel expiryWheel;
+    Random random;
+    TransformHierarchy hierarchy;
+    WorldBounds bounds;
+    WorldStreamer* streamer = nullptr;
+    // Flow field builds spread over these workers when the grid is large
+    // enough; null builds on the simulation thread.
+    ThreadPool* workers = nullptr;
+    NavGrid navGrid;
+    FlowField flowField;
+    bool navGridDirty = true;
+    Camera camera = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    Camera prevCamera = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    std::uint64_t tick = 0;
+};
+
+// Starts the camera on the player, so the first streaming update already
+// looks at the right regions.
+void initializeCamera(ECS& ecs, const DemoScene& scene, SimulationState& state) {
+    const Transform& playerTransform = ecs.getComponent<Transform>(scene.player);
+    updateCamera(state.camera, state.bounds, playerTransform.x + 32, playerTransform.y + 32);
+    state.prevCamera = state.camera;
+}
+
+// Rebuilds the grid when the static colliders may have changed and the field
+// when the player moves to another cell, then steers the enemies.
+void navigationSystem(ECS& ecs, const DemoScene& scene, SimulationState& state) {
+    if (ecs.pool<NavAgent>().count() == 0) return;
+    if (state.navGridDirty) {
+        state.navGrid.build(ecs, state.bounds.width, state.bounds.height, NAV_CELL_SIZE, ENEMY_RADIUS);
+        state.navGridDirty = false;
+    }
+    const Transform& playerTransform = ecs.getComponent<Transform>(scene.player);
+    state.flowField.update(state.navGrid, playerTransform.x + 32, playerTransform.y + 32, state.workers);
+    flowFieldSteeringSystem(ecs, state.flowField);
+}
+
+// One fixed step of every gameplay system. Both the windowed loop and the
+// headless runner go through here so they simulate identically.
+void simulationStep(ECS& ecs, const AnimationClipTable& animationClips, const DemoScene& scene,
+                    SimulationState& state, const Uint8* keystate, float deltaTime) {
+    PROFILE_SCOPE("simulationStep");
+    if (state.streamer != nullptr && state.streamer->update(ecs, state.camera)) {
+        state.hierarchy.invalidate();
+        state.navGridDirty = true;
+        const std::vector<Entity>& activated = state.streamer->activatedEntities();
+        scheduleExpiries(ecs, state.expiryWheel, activated.data(), activated.size());
+    }
+    { PROFILE_SCOPE("storePreviousTransforms"); storePreviousTransforms(ecs); }
+    state.prevCamera = state.camera;
+
+    { PROFILE_SCOPE("groundDetectionSystem"); groundDetectionSystem(ecs); }
+    { PROFILE_SCOPE("playerControllerSystem"); playerControllerSystem(ecs, deltaTime, keystate); }
+    { PROFILE_SCOPE("gravitySystem"); gravitySystem(ecs, deltaTime); }
+    { PROFILE_SCOPE("navigationSystem"); navigationSystem(ecs, scene, state); }
+    { PROFILE_SCOPE("movementSystem"); movementSystem(ecs, state.bounds, deltaTime); }
+    { PROFILE_SCOPE("physicsSystem"); physicsSystem(ecs, deltaTime); }
+    { PROFILE_SCOPE("transformHierarchySystem"); transformHierarchySystem(ecs, state.hierarchy); }
+    { PROFILE_SCOPE("animationSystem"); animationSystem(ecs, animationClips, deltaTime); }
+    { PROFILE_SCOPE("particleSystem"); particleSystem(ecs, state.expiryWheel, state.random, deltaTime); }
+    { PROFILE_SCOPE("expirySystem"); expirySystem(ecs, state.expiryWheel, deltaTime); }
+
+    auto& playerTransform = ecs.getComponent<Transform>(scene.player);
+    updateCamera(state.camera, state.bounds, playerTransform.x + 32, playerTransform.y + 32);
+    ++state.tick;
+
+    frameArena().reset();
+}
+
+struct SharedInput {
+    std::mutex mutex;
+    std::array<Uint8, SDL_NUM_SCANCODES> keys{};
+    std::vector<int> healthChanges;
+    // The render thread asks for memory stats; the simulation thread, which
+    // owns the ECS, fills in its half and hands them back.
+    bool memoryStatsRequested = false;
+    bool memoryStatsReady = false;
+    MemoryStats memoryStats;
+    bool rewindRequested = false;
+};
+
+// Rolls the world back by up to the given number of ticks. The expiry wheel,
+// the hierarchy order, the navigation grid and the streamer's region states
+// live outside the ECS, so they are rebuilt from the restored components.
+bool rewindSimulation(ECS& ecs, SnapshotHistory& history, SimulationState& state,
+                      std::uint64_t ticks, double stepSeconds) {
+    std::uint64_t target = state.tick > ticks ? state.tick - ticks : 0;
+    if (!history.restore(ecs, target)) return false;
+
+    state.tick = history.newestTick();
+    state.expiryWheel.reset(state.tick * stepSeconds);
+    scheduleExpiries(ecs, state.expiryWheel, false);
+    state.hierarchy.invalidate();
+    state.navGridDirty = true;
+    if (state.streamer != nullptr) state.streamer->resync(ecs);
+    return true;
+}
+
+// Owns the ECS once the loop starts: the render thread only ever sees the
+// snapshots published here. Simulation always advances in whole fixed steps;
+// wall-clock time only decides how many steps to run.
+void simulationLoop(ECS& ecs, const AnimationClipTable& animationClips, DemoScene scene, int tickRate,
+                    WorldBounds bounds, WorldStreamer* streamer, ThreadPool* workers,
+                    SharedInput& input, TripleBuffer<RenderSnapshot>& snapshots, std::atomic<bool>& isRunning) {
+    PROFILE_THREAD("Simulation");
+    const double STEP_SECONDS = 1.0 / tickRate;
+    const double MAX_ACCUMULATED = 0.25;
+    const double counterFrequency = (double)SDL_GetPerformanceFrequency();
+
+    SimulationState state;
+    state.bounds = bounds;
+    state.streamer = streamer;
+    state.workers = workers;
+    initializeCamera(ecs, scene, state);
+    std::array<Uint8, SDL_NUM_SCANCODES> keystate{};
+    std::vector<int> healthChanges;
+    scheduleExpiries(ecs, state.expiryWheel, true);
+
+    double accumulator = 0.0;
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+    std::uint64_t lastAllocations = 0;
+    bool memoryStatsRequested = false;
+    bool rewindRequested = false;
+
+    // Two seconds of world history for rewinding.
+    SnapshotHistory history(2 * tickRate);
+    history.push(ecs, state.tick);
+
+    while (isRunning.load(std::memory_order_relaxed)) {
+        Uint64 currentCounter = SDL_GetPerformanceCounter();
+        accumulator += (currentCounter - lastCounter) / counterFrequency;
+        lastCounter = currentCounter;
+        if (accumulator > MAX_ACCUMULATED) accumulator = MAX_ACCUMULATED;
+
+        if (accumulator < STEP_SECONDS) {
+            preciseWaitUntil(currentCounter + (Uint64)((STEP_SECONDS - accumulator) * counterFrequency));
+            continue;
+        }
+
+        std::uint64_t allocationsBefore = threadAllocationCounts().allocations;
+
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            keystate = input.keys;
+            healthChanges.swap(input.healthChanges);
+            memoryStatsRequested = input.memoryStatsRequested;
+            input.memoryStatsRequested = false;
+            rewindRequested = input.rewindRequested;
+            input.rewindRequested = false;
+        }
+
+        if (rewindRequested) {
+            PROFILE_SCOPE("rewind");
+            if (rewindSimulation(ecs, history, state, tickRate, STEP_SECONDS)) {
+                std::cout << "Rewound to tick " << state.tick << std::endl;
+            }
+            rewindRequested = false;
+        }
+
+        auto& playerHealth = ecs.getComponent<Health>(scene.player);
+        for (int change : healthChanges) {
+            playerHealth.current += change;
+            if (playerHealth.current < 0) playerHealth.current = 0;
+            if (playerHealth.current > playerHealth.max) playerHealth.current = playerHealth.max;
+        }
+        healthChanges.clear();
+
+        while (accumulator >= STEP_SECONDS) {
+            simulationStep(ecs, animationClips, scene, state, keystate.data(), (float)STEP_SECONDS);
+            { PROFILE_SCOPE("snapshotHistory"); history.push(ecs, state.tick); }
+            accumulator -= STEP_SECONDS;
+        }
+
+        PROFILE_SCOPE("buildRenderSnapshot");
+        RenderSnapshot& snapshot = snapshots.writeBuffer();
+        buildRenderSnapshot(ecs, scene.player, state.expiryWheel.time(), snapshot);
+        snapshot.tick = state.tick;
+        snapshot.cameraX = state.camera.x;
+        snapshot.cameraY = state.camera.y;
+        snapshot.prevCameraX = state.prevCamera.x;
+        snapshot.prevCameraY = state.prevCamera.y;
+        snapshot.interpolationBase = (float)(accumulator / STEP_SECONDS);
+        snapshot.stepSeconds = (float)STEP_SECONDS;
+        snapshot.publishCounter = SDL_GetPerformanceCounter();
+        snapshot.simulationAllocations = lastAllocations;
+        snapshots.publish();
+
+        if (memoryStatsRequested) {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            collectEcsMemoryStats(ecs, input.memoryStats);
+            input.memoryStats.simulationArenaReservedBytes = frameArena().bytesReserved();
+            input.memoryStats.simulationArenaHighWaterBytes = frameArena().highWaterMark();
+            input.memoryStats.simulationAllocationsPerPublish = lastAllocations;
+            input.memoryStatsReady = true;
+            memoryStatsRequested = false;
+        }
+
+        frameArena().reset();
+
+        lastAllocations = threadAllocationCounts().allocations - allocationsBefore;
+    }
+}
+
+// Runs the demo scene with no window, audio or renderer, as fast as the
+// systems allow, and reports throughput.
+int runHeadless(std::uint64_t ticks, int tickRate, const char* memoryStatsPath,
+                const char* scenePath, const char* writeScenePath,
+                const char* regionsPath, const char* writeRegionsPath) {
+    ECS ecs;
+    AnimationClipTable animationClips;
+    SceneTextures textures;
+    DemoScene scene;
+    SimulationState state;
+    ThreadPool workers;
+    state.workers = &workers;
+    SceneRegistry registry = defaultSceneRegistry();
+    WorldStreamer streamer(workers, registry);
+    if (regionsPath != nullptr) {
+        if (!openDemoRegions(ecs, streamer, regionsPath, textures, scene, state.bounds)) return 1;
+        state.streamer = &streamer;
+    } else if (scenePath != nullptr) {
+        if (!loadDemoScene(ecs, scenePath, textures, scene)) return 1;
+    } else {
+        scene = createDemoScene(ecs, state.bounds, nullptr, state.random);
+    }
+    if (writeRegionsPath != nullptr && !saveDemoRegions(ecs, writeRegionsPath, textures, state.bounds)) {
+        return 1;
+    }
+    initializeCamera(ecs, scene, state);
+    scheduleExpiries(ecs, state.expiryWheel, true);
+    std::array<Uint8, SDL_NUM_SCANCODES> keystate{};
+    const float STEP_SECONDS = 1.0f / tickRate;
+
+    // Allocations are counted after one simulated second of warm-up (or over
+    // the second half of a shorter run), once pools and arenas have grown to
+    // their working size.
+    std::uint64_t steadyStateStart = std::min<std::uint64_t>((std::uint64_t)tickRate, ticks / 2);
+    std::uint64_t allocationsAtSteadyState = 0;
+
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    for (std::uint64_t i = 0; i < ticks; ++i) {
+        if (i == steadyStateStart) {
+            allocationsAtSteadyState = threadAllocationCounts().allocations;
+        }
+        simulationStep(ecs, animationClips, scene, state, keystate.data(), STEP_SECONDS);
+    }
+    Uint64 endCounter = SDL_GetPerformanceCounter();
+    std::uint64_t steadyStateAllocations = threadAllocationCounts().allocations - allocationsAtSteadyState;
+
+    double wallSeconds = (double)(endCounter - startCounter) / (double)SDL_GetPerformanceFrequency();
+    double ticksPerSecond = wallSeconds > 0.0 ? ticks / wallSeconds : 0.0;
+    auto& playerTransform = ecs.getComponent<Transform>(scene.player);
+
+    std::cout << "Headless: " << ticks << " ticks at " << tickRate << " Hz ("
+              << ticks * (double)STEP_SECONDS << " s simulated) in " << wallSeconds << " s, "
+              << ticksPerSecond << " ticks/sec" << std::endl;
+    std::cout << "Final player position: (" << playerTransform.x << ", " << playerTransform.y << ")" << std::endl;
+    std::cout << "Heap allocations over the last " << ticks - steadyStateStart << " ticks: "
+              << steadyStateAllocations << std::endl;
+    if (state.streamer != nullptr) {
+        std::cout << "Streaming: " << streamer.activeRegionCount() << " active regions, "
+                  << streamer.cachedRegionCount() << " chunks cached (" << streamer.cachedBytes() << " bytes), "
+                  << ecs.entities().livingCount() << " entities resident" << std::endl;
+    }
+
+    if (memoryStatsPath != nullptr) {
+        MemoryStats stats;
+        collectEcsMemoryStats(ecs, stats);
+        collectHeapMemoryStats(stats);
+        stats.simulationArenaReservedBytes = frameArena().bytesReserved();
+        stats.simulationArenaHighWaterBytes = frameArena().highWaterMark();
+        stats.simulationAllocationsPerPublish = steadyStateAllocations / std::max<std::uint64_t>(1, ticks - steadyStateStart);
+        if (!writeMemoryStatsJson(stats, memoryStatsPath)) {
+            std::cout << "Failed to write " << memoryStatsPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << memoryStatsPath << std::endl;
+    }
+
+    if (writeScenePath != nullptr && !saveDemoScene(ecs, writeScenePath, textures)) {
+        return 1;
+    }
+    return 0;
+}
+
+// One world's own settings, for hosting many simulations in one process.
+struct WorldConfig {
+    Entity capacity = MAX_ENTITIES;
+    WorldBounds bounds;
+    std::uint32_t seed = 1;
+};
+
+// Everything one demo simulation owns. Worlds only share read-only data (the
+// animation clip table and the idle keyboard state), so each can be stepped
+// on a different thread.
+struct World {
+    ECS ecs;
+    DemoScene scene;
+    SimulationState state;
+
+    explicit World(const WorldConfig& config) : ecs(config.capacity) {
+        state.bounds = config.bounds;
+        state.random = Random(config.seed);
+        scene = createDemoScene(ecs, state.bounds, nullptr, state.random);
+        initializeCamera(ecs, scene, state);
+        scheduleExpiries(ecs, state.expiryWheel, true);
+    }
+};
+
+// Steps worldCount independent demo worlds on a thread pool, one task per
+// world per simulated second, and reports the combined throughput. World i
+// is seeded with i + 1, so world 0 replays the single-world headless run.
+int runWorlds(size_t worldCount, std::uint64_t ticks, int tickRate) {
+    // The demo scene peaks at a few dozen entities.
+    const Entity WORLD_CAPACITY = 256;
+    const float STEP_SECONDS = 1.0f / tickRate;
+    AnimationClipTable animationClips;
+    std::array<Uint8, SDL_NUM_SCANCODES> keystate{};
+
+    // The caller only waits, so every core gets a worker.
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    std::int64_t heapBefore = heapCounters().liveBytes.load(std::memory_order_relaxed);
+
+    std::vector<std::unique_ptr<World>> worlds;
+    worlds.reserve(worldCount);
+    for (size_t i = 0; i < worldCount; ++i) {
+        worlds.push_back(std::make_unique<World>(WorldConfig{WORLD_CAPACITY, WorldBounds(), (std::uint32_t)i + 1}));
+    }
+
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    for (std::uint64_t done = 0; done < ticks;) {
+        std::uint64_t batch = std::min<std::uint64_t>(tickRate, ticks - done);
+        for (auto& world : worlds) {
+            World* stepped = world.get();
+            pool.submit([stepped, batch, STEP_SECONDS, &animationClips, &keystate] {
+                for (std::uint64_t i = 0; i < batch; ++i) {
+                    simulationStep(stepped->ecs, animationClips, stepped->scene, stepped->state, keystate.data(),
+                                   STEP_SECONDS);
+                }
+            });
+        }
+        pool.waitIdle();
+        done += batch;
+    }
+    Uint64 endCounter = SDL_GetPerformanceCounter();
+
+    double wallSeconds = (double)(endCounter - startCounter) / (double)SDL_GetPerformanceFrequency();
+    double worldTicks = (double)ticks * worldCount;
+    std::int64_t heapPerWorld = (heapCounters().liveBytes.load(std::memory_order_relaxed) - heapBefore) /
+                                (std::int64_t)std::max<size_t>(1, worldCount);
+    MemoryStats stats;
+    collectEcsMemoryStats(worlds[0]->ecs, stats);
+    auto& playerTransform = worlds[0]->ecs.getComponent<Transform>(worlds[0]->scene.player);
+
+    std::cout << "Worlds: " << worldCount << " x " << ticks << " ticks at " << tickRate << " Hz on "
+              << pool.threadCount() << " threads in " << wallSeconds << " s, "
+              << (wallSeconds > 0.0 ? worldTicks / wallSeconds : 0.0) << " world-ticks/sec" << std::endl;
+    std::cout << "World 0 final player position: (" << playerTransform.x << ", " << playerTransform.y << ")" << std::endl;
+    std::cout << "Per world: " << stats.poolReservedBytes + stats.indexBytes + stats.entityManagerBytes
+              << " bytes of ECS storage for " << stats.maxEntities << " entity slots, " << heapPerWorld
+              << " bytes of heap in total" << std::endl;
+    return 0;
 }
 
 #undef main
 int main(int argc, char* argv[]) {
+    bool useSoftwareRenderer = false;
+    TextureFilter softwareFilter = TextureFilter::Nearest;
+    bool useVsync = false;
+    bool logFrameStats = false;
+    int tickRate = 60;
+    std::uint64_t headlessTicks = 0;
+    const char* memoryStatsPath = nullptr;
+    const char* scenePath = nullptr;
+    const char* writeScenePath = nullptr;
+    const char* regionsPath = nullptr;
+    const char* writeRegionsPath = nullptr;
+    size_t worldCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--software-renderer") {
+            useSoftwareRenderer = true;
+        } else if (arg == "--bilinear") {
+            softwareFilter = TextureFilter::Bilinear;
+        } else if (arg == "--vsync") {
+            useVsync = true;
+        } else if (arg == "--frame-stats") {
+            logFrameStats = true;
+        } else if (arg == "--tick-rate" && i + 1 < argc) {
+            tickRate = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--headless" && i + 1 < argc) {
+            headlessTicks = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--memory-stats" && i + 1 < argc) {
+            memoryStatsPath = argv[++i];
+        } else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--write-scene" && i + 1 < argc) {
+            writeScenePath = argv[++i];
+        } else if (arg == "--regions" && i + 1 < argc) {
+            regionsPath = argv[++i];
+        } else if (arg == "--write-regions" && i + 1 < argc) {
+            writeRegionsPath = argv[++i];
+        } else if (arg == "--worlds" && i + 1 < argc) {
+            worldCount = strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    if (headlessTicks > 0 && worldCount > 0) {
+        return runWorlds(worldCount, headlessTicks, tickRate);
+    }
+    if (headlessTicks > 0) {
+        return runHeadless(headlessTicks, tickRate, memoryStatsPath, scenePath, writeScenePath,
+                           regionsPath, writeRegionsPath);
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
         std::cout << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
         return -1;
@@ -231,45 +904,34 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-
-    if (renderer == nullptr) {
-        std::cout << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window);
-        TTF_Quit();
-        Mix_Quit();
-        IMG_Quit();
-        SDL_Quit();
-        return -1;
-    }
-
-    TTF_Font* font = TTF_OpenFont("assets/PressStart2P-Regular.ttf", 14);
-    if (font == nullptr) {
-        std::cout << "Failed to load font! SDL_ttf Error: " << TTF_GetError() << std::endl;
-    }
-
-    const int DAMAGE_CHANNEL = 0;
-    const int HEAL_CHANNEL   = 1;
+    SDL_Renderer* renderer = nullptr;
+    std::unique_ptr<RenderBackend> backend;
+    // Whether presenting actually waits for vblank. The software renderer
+    // never does, and a driver may not grant it, so otherwise the frame
+    // limiter stays on.
+    bool vsyncActive = false;
 
-    Mix_Chunk* damageSound = Mix_LoadWAV("assets/sounds/845959__josefpres__piano-loops-205-octave-long-loop-120-bpm.wav");
-    if (damageSound == nullptr) {
-        std::cout << "Failed to load damage sound! SDL_mixer Error: " << Mix_GetError() << std::endl;
+    if (useSoftwareRenderer) {
+        backend = std::make_unique<SoftwareRenderBackend>(SCREEN_WIDTH, SCREEN_HEIGHT, window, softwareFilter);
     } else {
-        Mix_VolumeChunk(damageSound, 64);   // softer, ~50% volume for damage
+        Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+        if (useVsync) {
+            rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+        }
+        renderer = SDL_CreateRenderer(window, -1, rendererFlags);
+        if (renderer != nullptr) {
+            backend = std::make_unique<SDLRenderBackend>(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+            SDL_RendererInfo rendererInfo;
+            vsyncActive = useVsync && SDL_GetRendererInfo(renderer, &rendererInfo) == 0 &&
+                          (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+        }
     }
-
-    Mix_Chunk* healSound = Mix_LoadWAV("assets/sounds/845959__josefpres__piano-loops-205-octave-long-loop-120-bpm.wav");
-    if (healSound == nullptr) {
-        std::cout << "Failed to load heal sound! SDL_mixer Error: " << Mix_GetError() << std::endl;
-    } else {
-        Mix_VolumeChunk(healSound, 128);    // full volume for heal
+    if (useVsync && !vsyncActive) {
+        std::cout << "Vsync is not available with this renderer; using the frame limiter" << std::endl;
     }
 
-    SDL_Surface* loadedSurface = IMG_Load("assets/test_sprite.png");
-    if (loadedSurface == nullptr) {
-        std::cout << "Unable to load image! SDL_image Error: " << IMG_GetError() << std::endl;
-        TTF_CloseFont(font);
-        SDL_DestroyRenderer(renderer);
+    if (backend == nullptr) {
+        std::cout << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         SDL_DestroyWindow(window);
         TTF_Quit();
         Mix_Quit();
@@ -278,97 +940,93 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
-    SDL_Texture* spriteTexture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
-    SDL_FreeSurface(loadedSurface);
+    // Everything is requested up front so the decodes overlap on the worker
+    // threads; the loop uploads results as they arrive and draws the
+    // placeholder until then.
+    ThreadPool workers;
+    auto assets = std::make_unique<AssetLoader>(workers, *backend);
 
-    if (spriteTexture == nullptr) {
-        std::cout << "Unable to create texture! SDL Error: " << SDL_GetError() << std::endl;
-        TTF_CloseFont(font);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        TTF_Quit();
-        Mix_Quit();
-        IMG_Quit();
-        SDL_Quit();
-        return -1;
-    }
+    const FontAsset* hudFont = assets->loadFont("assets/PressStart2P-Regular.ttf", 14);
+    const TextureAsset* spriteTexture = assets->loadTexture("assets/test_sprite.png");
+
+    // Damage and heal share one sample, loaded (or streamed, if it is long)
+    // once; the volume tells them apart.
+    AudioManager audio;
+    const SoundAsset* damageSound = assets->loadSound("assets/sounds/845959__josefpres__piano-loops-205-octave-long-loop-120-bpm.wav");
+    const SoundAsset* healSound = assets->loadSound("assets/sounds/845959__josefpres__piano-loops-205-octave-long-loop-120-bpm.wav");
 
     ECS ecs;
+    AnimationClipTable animationClips;
 
-    Entity player = ecs.createEntity();
-    ecs.addComponent(player, Transform{400.0f, 100.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(player, Sprite{spriteTexture, 64, 64, 0, 0, 0, 0});
-    ecs.addComponent(player, Velocity{0.0f, 0.0f});
-    ecs.addComponent(player, Collider{64.0f, 64.0f, 0.0f, 0.0f, false});
-    ecs.addComponent(player, RigidBody{1.0f, true, 1.0f, false});
-    ecs.addComponent(player, PlayerController{300.0f, 500.0f, false});
-    ecs.addComponent(player, Health{100, 100});
+    SceneTextures sceneTextures;
+    sceneTextures.add("assets/test_sprite.png", nullptr, spriteTexture);
 
-    Entity playerParticles = ecs.createEntity();
-    ecs.addComponent(playerParticles, Transform{400.0f, 100.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(playerParticles, ParticleEmitter{
-        20.0f, 0.5f, 0.0f, 50, true,
-        -50.0f, 50.0f, -100.0f, -50.0f
-    });
+    SceneRegistry sceneRegistry = defaultSceneRegistry();
+    WorldStreamer streamer(workers, sceneRegistry);
+    WorldStreamer* activeStreamer = nullptr;
+    WorldBounds worldBounds;
 
-    Entity ground = ecs.createEntity();
-    ecs.addComponent(ground, Transform{0.0f, WORLD_HEIGHT - 100.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(ground, Collider{(float)WORLD_WIDTH, 100.0f, 0.0f, 0.0f, false});
-    ecs.addComponent(ground, RigidBody{1.0f, false, 0.0f, true});
+    DemoScene scene;
+    if (regionsPath != nullptr && openDemoRegions(ecs, streamer, regionsPath, sceneTextures, scene, worldBounds)) {
+        activeStreamer = &streamer;
+    } else if (scenePath == nullptr || !loadDemoScene(ecs, scenePath, sceneTextures, scene)) {
+        ecs = ECS();
+        worldBounds = WorldBounds();
+        Random sceneRandom;
+        scene = createDemoScene(ecs, worldBounds, spriteTexture, sceneRandom);
+    }
+    if (writeScenePath != nullptr) {
+        saveDemoScene(ecs, writeScenePath, sceneTextures);
+    }
+    if (writeRegionsPath != nullptr) {
+        saveDemoRegions(ecs, writeRegionsPath, sceneTextures, worldBounds);
+    }
 
-    Entity platform1 = ecs.createEntity();
-    ecs.addComponent(platform1, Transform{300.0f, 800.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(platform1, Collider{400.0f, 50.0f, 0.0f, 0.0f, false});
-    ecs.addComponent(platform1, RigidBody{1.0f, false, 0.0f, true});
+    SharedInput input;
+    TripleBuffer<RenderSnapshot> snapshots;
+    std::atomic<bool> isRunning{true};
 
-    Entity platform2 = ecs.createEntity();
-    ecs.addComponent(platform2, Transform{800.0f, 600.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(platform2, Collider{400.0f, 50.0f, 0.0f, 0.0f, false});
-    ecs.addComponent(platform2, RigidBody{1.0f, false, 0.0f, true});
+    buildRenderSnapshot(ecs, scene.player, 0.0f, snapshots.writeBuffer());
+    snapshots.publish();
 
-    Entity platform3 = ecs.createEntity();
-    ecs.addComponent(platform3, Transform{1300.0f, 900.0f, 0.0f, 1.0f, 1.0f});
-    ecs.addComponent(platform3, Collider{300.0f, 50.0f, 0.0f, 0.0f, false});
-    ecs.addComponent(platform3, RigidBody{1.0f, false, 0.0f, true});
+    std::thread simulationThread(simulationLoop, std::ref(ecs), std::cref(animationClips), scene, tickRate,
+                                 worldBounds, activeStreamer, &workers,
+                                 std::ref(input), std::ref(snapshots), std::ref(isRunning));
 
-    for (int i = 0; i < 5; ++i) {
-        Entity ball = ecs.createEntity();
-        
-        float randomX = 500.0f + (float)(rand() % 800);
-        float randomY = 200.0f + (float)(rand() % 300);
-        float randomScale = 0.5f + (float)(rand() % 100) / 100.0f;
-        
-        ecs.addComponent(ball, Transform{randomX, randomY, 0.0f, randomScale, randomScale});
-        ecs.addComponent(ball, Sprite{spriteTexture, 64, 64, 0, 0, 0, 0});
-        ecs.addComponent(ball, Velocity{0.0f, 0.0f});
-        ecs.addComponent(ball, Collider{64.0f * randomScale, 64.0f * randomScale, 0.0f, 0.0f, false});
-        ecs.addComponent(ball, RigidBody{1.0f, true, 1.0f, false});
-    }
+    StaticLayerCache staticLayer(*backend, (int)worldBounds.width, (int)worldBounds.height, 100);
+    DrawQueue drawQueue;
 
-    bool isRunning = true;
     SDL_Event event;
 
     const int FPS = 60;
-    const int FRAME_DELAY = 1000 / FPS;
-    Uint32 frameStart;
-    int frameTime;
-
-    Camera camera = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    FramePacer framePacer(FPS, vsyncActive);
 
-    Uint32 lastTime = SDL_GetTicks();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
 
     bool showColliders = false;
+    bool saveFrameRequested = false;
+    bool showProfiler = false;
+    std::vector<ProfileSummaryEntry> profileSummary;
+    float profileSummaryTimer = 0.0f;
     
     int frameCount = 0;
     float fpsTimer = 0.0f;
     int currentFPS = 0;
+    float statsLogTimer = 0.0f;
+
+    PROFILE_THREAD("Render");
+
+    std::uint64_t lastFrameAllocations = 0;
+    MemoryStats memoryStats;
+    bool memoryStatsReady = false;
 
-    while (isRunning) {
-        frameStart = SDL_GetTicks();
-        Uint32 currentTime = SDL_GetTicks();
-        float deltaTime = (currentTime - lastTime) / 1000.0f;
-        if (deltaTime > 0.05f) deltaTime = 0.05f;
-        lastTime = currentTime;
+    while (isRunning.load(std::memory_order_relaxed)) {
+        framePacer.beginFrame();
+        { PROFILE_SCOPE("assetUploads"); assets->processCompletions(4); }
+        std::uint64_t allocationsBefore = threadAllocationCounts().allocations;
+        Uint64 currentCounter = SDL_GetPerformanceCounter();
+        float deltaTime = (float)((double)(currentCounter - lastCounter) / SDL_GetPerformanceFrequency());
+        lastCounter = currentCounter;
 
         frameCount++;
         fpsTimer += deltaTime;
@@ -378,11 +1036,22 @@ int main(int argc, char* argv[]) {
             fpsTimer = 0.0f;
         }
 
+        FrameStats frameStats = framePacer.stats();
+        statsLogTimer += deltaTime;
+        if (logFrameStats && statsLogTimer >= 5.0f) {
+            logFrameTimes(frameStats);
+            statsLogTimer = 0.0f;
+        }
+
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 isRunning = false;
             }
 
+            if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+                staticLayer.invalidateAll();
+            }
+
             if (event.type == SDL_KEYDOWN) {
                 if (event.key.keysym.sym == SDLK_ESCAPE) {
                     isRunning = false;
@@ -390,113 +1059,123 @@ int main(int argc, char* argv[]) {
                 if (event.key.keysym.sym == SDLK_c) {
                     showColliders = !showColliders;
                 }
+                if (event.key.keysym.sym == SDLK_p) {
+                    showProfiler = !showProfiler;
+                }
+                if (event.key.keysym.sym == SDLK_t) {
+                    if (Profiler::instance().writeChromeTrace("profile_trace.json")) {
+                        std::cout << "Wrote profile_trace.json" << std::endl;
+                    } else {
+                        std::cout << "Failed to write profile_trace.json" << std::endl;
+                    }
+                }
+                if (event.key.keysym.sym == SDLK_m) {
+                    std::lock_guard<std::mutex> lock(input.mutex);
+                    input.memoryStatsRequested = true;
+                }
+                if (event.key.keysym.sym == SDLK_BACKSPACE) {
+                    std::lock_guard<std::mutex> lock(input.mutex);
+                    input.rewindRequested = true;
+                }
+                if (event.key.keysym.sym == SDLK_F12) {
+                    saveFrameRequested = true;
+                }
                 if (event.key.keysym.sym == SDLK_h && event.key.repeat == 0) {
-                    auto& playerHealth = ecs.getComponent<Health>(player);
-                    playerHealth.current -= 10;
-                    if (playerHealth.current < 0) playerHealth.current = 0;
-                    if (damageSound != nullptr) {
-                        Mix_HaltChannel(DAMAGE_CHANNEL);
-                        Mix_PlayChannel(DAMAGE_CHANNEL, damageSound, 0);
+                    {
+                        std::lock_guard<std::mutex> lock(input.mutex);
+                        input.healthChanges.push_back(-10);
                     }
+                    const RenderSnapshot& last = snapshots.readBuffer();
+                    audio.play(damageSound, SoundParams{1, 0.5f, true, last.hud.playerX, last.hud.playerY});
                 }
                 if (event.key.keysym.sym == SDLK_j && event.key.repeat == 0) {
-                    auto& playerHealth = ecs.getComponent<Health>(player);
-                    playerHealth.current += 10;
-                    if (playerHealth.current > playerHealth.max) playerHealth.current = playerHealth.max;
-                    if (healSound != nullptr) {
-                        Mix_HaltChannel(HEAL_CHANNEL);
-                        Mix_PlayChannel(HEAL_CHANNEL, healSound, 0);
+                    {
+                        std::lock_guard<std::mutex> lock(input.mutex);
+                        input.healthChanges.push_back(10);
                     }
+                    const RenderSnapshot& last = snapshots.readBuffer();
+                    audio.play(healSound, SoundParams{1, 1.0f, true, last.hud.playerX, last.hud.playerY});
                 }
             }
         }
 
         const Uint8* keystate = SDL_GetKeyboardState(NULL);
-
-        groundDetectionSystem(ecs);
-        playerControllerSystem(ecs, deltaTime, keystate);
-        gravitySystem(ecs, deltaTime);
-        movementSystem(ecs, deltaTime);
-        physicsSystem(ecs, deltaTime);
-        animationSystem(ecs, deltaTime);
-        particleSystem(ecs, deltaTime);
-        lifetimeSystem(ecs, deltaTime);
-
-        auto& playerTransform = ecs.getComponent<Transform>(player);
-        auto& particleEmitterTransform = ecs.getComponent<Transform>(playerParticles);
-        particleEmitterTransform.x = playerTransform.x + 32;
-        particleEmitterTransform.y = playerTransform.y + 64;
-
-        updateCamera(camera, playerTransform.x + 32, playerTransform.y + 32);
-
-        SDL_SetRenderDrawColor(renderer, 30, 30, 46, 255);
-        SDL_RenderClear(renderer);
-
-        SDL_SetRenderDrawColor(renderer, 80, 80, 100, 255);
-        for (int x = 0; x < WORLD_WIDTH; x += 100) {
-            SDL_Rect line = {x - (int)camera.x, 0, 2, SCREEN_HEIGHT};
-            SDL_RenderFillRect(renderer, &line);
-        }
-        for (int y = 0; y < WORLD_HEIGHT; y += 100) {
-            SDL_Rect line = {0, y - (int)camera.y, SCREEN_WIDTH, 2};
-            SDL_RenderFillRect(renderer, &line);
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            std::copy(keystate, keystate + SDL_NUM_SCANCODES, input.keys.begin());
+            if (input.memoryStatsReady) {
+                memoryStats = input.memoryStats;
+                memoryStatsReady = true;
+                input.memoryStatsReady = false;
+            }
         }
 
-        SDL_SetRenderDrawColor(renderer, 100, 100, 120, 255);
-        auto platforms = ecs.getEntitiesWithComponent<RigidBody>();
-        for (Entity entity : platforms) {
-            if (ecs.hasComponent<Collider>(entity) && !ecs.hasComponent<Sprite>(entity)) {
-                auto& transform = ecs.getComponent<Transform>(entity);
-                auto& collider = ecs.getComponent<Collider>(entity);
-                
-                int screenX = (int)(transform.x - camera.x);
-                int screenY = (int)(transform.y - camera.y);
-                
-                SDL_Rect rect = {screenX, screenY, (int)collider.width, (int)collider.height};
-                SDL_RenderFillRect(renderer, &rect);
+        if (memoryStatsReady) {
+            memoryStats.textureBytes = backend->textureBytes();
+            memoryStats.audioBytes = assets->audioBytes();
+            memoryStats.renderArenaReservedBytes = frameArena().bytesReserved();
+            memoryStats.renderArenaHighWaterBytes = frameArena().highWaterMark();
+            memoryStats.renderAllocationsPerFrame = lastFrameAllocations;
+            collectHeapMemoryStats(memoryStats);
+
+            const char* path = memoryStatsPath != nullptr ? memoryStatsPath : "memory_stats.json";
+            if (writeMemoryStatsJson(memoryStats, path)) {
+                std::cout << "Wrote " << path << " (heap " << memoryStats.heapLiveBytes << " bytes, peak "
+                          << memoryStats.heapPeakBytes << ")" << std::endl;
+            } else {
+                std::cout << "Failed to write " << path << std::endl;
             }
+            memoryStatsReady = false;
         }
 
-        renderParticles(ecs, renderer, camera);
-        renderSystem(ecs, renderer, camera);
+        snapshots.acquire();
+        const RenderSnapshot& snapshot = snapshots.readBuffer();
+        audio.setListener(Camera{snapshot.cameraX, snapshot.cameraY, SCREEN_WIDTH, SCREEN_HEIGHT});
+        float alpha = 1.0f;
+        if (snapshot.stepSeconds > 0.0f) {
+            double sincePublish = (double)(SDL_GetPerformanceCounter() - snapshot.publishCounter) /
+                                  (double)SDL_GetPerformanceFrequency();
+            alpha = std::min(1.0f, snapshot.interpolationBase + (float)(sincePublish / snapshot.stepSeconds));
+        }
+        TTF_Font* font = hudFont->readyFont();
+        {
+            PROFILE_SCOPE("renderFrame");
+            renderFrame(snapshot, alpha, *backend, staticLayer, drawQueue, font, showColliders, currentFPS, frameStats,
+                        lastFrameAllocations);
+        }
 
-        if (showColliders) {
-            debugRenderColliders(ecs, renderer, camera);
+        if (showProfiler) {
+            profileSummaryTimer += deltaTime;
+            if (profileSummaryTimer >= 0.25f || profileSummary.empty()) {
+                Profiler::instance().summarize(1.0, profileSummary);
+                profileSummaryTimer = 0.0f;
+            }
+            renderProfilerOverlay(*backend, font, profileSummary);
         }
 
-        if (font != nullptr) {
-            auto& playerHealth = ecs.getComponent<Health>(player);
-            
-            renderHealthBar(renderer, 10, 10, 200, 20, playerHealth.current, playerHealth.max);
-            
-            char healthText[32];
-            sprintf(healthText, "HP: %d/%d", playerHealth.current, playerHealth.max);
-            SDL_Color white = {255, 255, 255, 255};
-            renderText(renderer, font, healthText, 10, 35, white);
-            
-            char fpsText[32];
-            sprintf(fpsText, "FPS: %d", currentFPS);
-            renderText(renderer, font, fpsText, 10, 65, white);
-            
-            char posText[64];
-            sprintf(posText, "Pos: (%.0f, %.0f)", playerTransform.x, playerTransform.y);
-            renderText(renderer, font, posText, 10, 95, white);
-            
-            renderText(renderer, font, "H - Damage  J - Heal", 10, SCREEN_HEIGHT - 30, white);
+        if (saveFrameRequested) {
+            char framePath[64];
+            sprintf(framePath, "frame_%llu.png", (unsigned long long)snapshot.tick);
+            if (!backend->saveFrame(framePath)) {
+                std::cout << "Failed to save frame! SDL Error: " << SDL_GetError() << std::endl;
+            }
+            saveFrameRequested = false;
         }
 
-        SDL_RenderPresent(renderer);
+        { PROFILE_SCOPE("present"); backend->present(); }
 
-        frameTime = SDL_GetTicks() - frameStart;
-        if (frameTime < FRAME_DELAY) {
-            SDL_Delay(FRAME_DELAY - frameTime);
-        }
+        frameArena().reset();
+        lastFrameAllocations = threadAllocationCounts().allocations - allocationsBefore;
+
+        { PROFILE_SCOPE("waitForNextFrame"); framePacer.waitForNextFrame(); }
     }
 
-    SDL_DestroyTexture(spriteTexture);
-    TTF_CloseFont(font);
-    Mix_FreeChunk(damageSound);
-    Mix_FreeChunk(healSound);
+    simulationThread.join();
+    logFrameTimes(framePacer.stats());
+
+    staticLayer.release();
+    audio.stopAll();
+    assets.reset();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     TTF_Quit();